@@ -0,0 +1,329 @@
+/*
+ * Benchmark of heap.h against std::priority_queue.
+ *
+ * Build and run from the repository root:
+ * c++ -O2 -I. bench/heap_bench.cpp -o heap_bench && ./heap_bench [max_size]
+ * Compile with -DHEAP_STATS to report element moves per operation of heap.h as well.
+ *
+ * Workloads (n = heap size):
+ * push    n pushes into an empty heap
+ * pop     n pops from a heap with n elements
+ * mixed   n pop + push pairs on a heap with n elements
+ * heapify building a heap from n elements at once
+ * topk    keeping the greatest n / 100 of 10 * n streamed elements
+ *
+ * Heap sizes start at 1K and grow by a factor of 10 up to max_size (default 1M, at most 100M).
+ * The element sizes are 4, 16 and 64 bytes, elements are compared by a 32 bit key.
+ * Every implementation is run with the same input and the same counting comparison function.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "heap.h"
+
+static unsigned long comparisons = 0;
+
+struct Element4
+{
+    unsigned int key;
+};
+
+struct Element16
+{
+    unsigned int key;
+    char payload[12];
+};
+
+struct Element64
+{
+    unsigned int key;
+    char payload[60];
+};
+
+/* heap.h compare: <0 if first element is bigger */
+template <typename Element>
+static int element_compare(Element a, Element b)
+{
+    comparisons++;
+
+    return (a.key < b.key) - (a.key > b.key);
+}
+
+/* std::priority_queue compare: true if a has a lower priority, i.e. the top is the smallest key */
+template <typename Element>
+struct ElementGreater
+{
+    bool operator()(const Element &a, const Element &b) const
+    {
+        comparisons++;
+
+        return a.key > b.key;
+    }
+};
+
+/* arity of the d-ary heap variants: all children in one cache line, 4 lines for 64 byte elements */
+DECL_HEAP(Element4, Binary4, element_compare<Element4>)
+DECL_DHEAP(Element4, Dary4, element_compare<Element4>, 16)
+DECL_HEAP(Element16, Binary16, element_compare<Element16>)
+DECL_DHEAP(Element16, Dary16, element_compare<Element16>, 4)
+DECL_HEAP(Element64, Binary64, element_compare<Element64>)
+DECL_DHEAP(Element64, Dary64, element_compare<Element64>, 4)
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result
+{
+    double nanoseconds;
+    unsigned long comparisons;
+    unsigned long moves;
+    size_t checksum;
+};
+
+static std::vector<unsigned int> keys;
+
+static double elapsed(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+template <typename Element>
+static Element make_element(size_t i)
+{
+    Element element;
+
+    std::memset(&element, 0, sizeof(element));
+    element.key = keys[i % keys.size()];
+
+    return element;
+}
+
+#ifdef HEAP_STATS
+#define HEAP_MOVES(heap) ((heap)->stats.moves)
+#else
+#define HEAP_MOVES(heap) 0UL
+#endif
+
+/* Declares run_NAME(workload, n) for a heap declared with DECL_HEAP or DECL_DHEAP. */
+#define DECL_HEAP_RUNNER(Element, type_name)                                                               \
+    static Result run_##type_name(const char *workload, size_t n)                                          \
+    {                                                                                                      \
+        std::vector<Element> input(n);                                                                     \
+        type_name##_Heap *heap;                                                                            \
+        Clock::time_point start;                                                                           \
+        Result result;                                                                                     \
+        size_t i;                                                                                          \
+                                                                                                           \
+        for (i = 0; i < n; i++)                                                                            \
+        {                                                                                                  \
+            input[i] = make_element<Element>(i);                                                           \
+        }                                                                                                  \
+                                                                                                           \
+        result.checksum = 0;                                                                               \
+        heap = type_name##_heap_create(n);                                                                 \
+                                                                                                           \
+        if (std::strcmp(workload, "push") != 0 && std::strcmp(workload, "heapify") != 0 &&                 \
+            std::strcmp(workload, "topk") != 0)                                                            \
+        {                                                                                                  \
+            type_name##_heap_push_batch(heap, input.data(), n);                                            \
+        }                                                                                                  \
+                                                                                                           \
+        comparisons = 0;                                                                                   \
+        HEAP_STATS_RESET(heap);                                                                            \
+        start = Clock::now();                                                                              \
+                                                                                                           \
+        if (std::strcmp(workload, "push") == 0)                                                            \
+        {                                                                                                  \
+            for (i = 0; i < n; i++)                                                                        \
+            {                                                                                              \
+                type_name##_heap_push(heap, input[i]);                                                     \
+            }                                                                                              \
+        }                                                                                                  \
+        else if (std::strcmp(workload, "pop") == 0)                                                        \
+        {                                                                                                  \
+            for (i = 0; i < n; i++)                                                                        \
+            {                                                                                              \
+                result.checksum += type_name##_heap_pop(heap).key;                                         \
+            }                                                                                              \
+        }                                                                                                  \
+        else if (std::strcmp(workload, "mixed") == 0)                                                      \
+        {                                                                                                  \
+            for (i = 0; i < n; i++)                                                                        \
+            {                                                                                              \
+                result.checksum += type_name##_heap_pop(heap).key;                                         \
+                type_name##_heap_push(heap, make_element<Element>(n + i));                                 \
+            }                                                                                              \
+        }                                                                                                  \
+        else if (std::strcmp(workload, "heapify") == 0)                                                    \
+        {                                                                                                  \
+            type_name##_heap_push_batch(heap, input.data(), n);                                            \
+        }                                                                                                  \
+        else                                                                                               \
+        {                                                                                                  \
+            for (i = 0; i < 10 * n; i++)                                                                   \
+            {                                                                                              \
+                type_name##_heap_push_bounded(heap, make_element<Element>(i), n / 100 + 1);                \
+            }                                                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        result.nanoseconds = elapsed(start);                                                               \
+        result.comparisons = comparisons;                                                                  \
+        result.moves = HEAP_MOVES(heap);                                                                   \
+        result.checksum += heap->size;                                                                     \
+        type_name##_heap_destroy(heap);                                                                    \
+                                                                                                           \
+        return result;                                                                                     \
+    }
+
+DECL_HEAP_RUNNER(Element4, Binary4)
+DECL_HEAP_RUNNER(Element4, Dary4)
+DECL_HEAP_RUNNER(Element16, Binary16)
+DECL_HEAP_RUNNER(Element16, Dary16)
+DECL_HEAP_RUNNER(Element64, Binary64)
+DECL_HEAP_RUNNER(Element64, Dary64)
+
+template <typename Element>
+static Result run_std(const char *workload, size_t n)
+{
+    typedef std::priority_queue<Element, std::vector<Element>, ElementGreater<Element> > Queue;
+    std::vector<Element> input(n);
+    Clock::time_point start;
+    Result result;
+    Queue queue;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        input[i] = make_element<Element>(i);
+    }
+
+    result.checksum = 0;
+
+    if (std::strcmp(workload, "push") != 0 && std::strcmp(workload, "heapify") != 0 &&
+        std::strcmp(workload, "topk") != 0)
+    {
+        queue = Queue(input.begin(), input.end());
+    }
+
+    comparisons = 0;
+    start = Clock::now();
+
+    if (std::strcmp(workload, "push") == 0)
+    {
+        for (i = 0; i < n; i++)
+        {
+            queue.push(input[i]);
+        }
+    }
+    else if (std::strcmp(workload, "pop") == 0)
+    {
+        for (i = 0; i < n; i++)
+        {
+            result.checksum += queue.top().key;
+            queue.pop();
+        }
+    }
+    else if (std::strcmp(workload, "mixed") == 0)
+    {
+        for (i = 0; i < n; i++)
+        {
+            result.checksum += queue.top().key;
+            queue.pop();
+            queue.push(make_element<Element>(n + i));
+        }
+    }
+    else if (std::strcmp(workload, "heapify") == 0)
+    {
+        queue = Queue(input.begin(), input.end());
+    }
+    else
+    {
+        size_t limit = n / 100 + 1;
+        ElementGreater<Element> greater;
+
+        for (i = 0; i < 10 * n; i++)
+        {
+            Element element = make_element<Element>(i);
+
+            if (queue.size() < limit)
+            {
+                queue.push(element);
+            }
+            else if (greater(element, queue.top()))
+            {
+                queue.pop();
+                queue.push(element);
+            }
+        }
+    }
+
+    result.nanoseconds = elapsed(start);
+    result.comparisons = comparisons;
+    result.moves = 0;
+    result.checksum += queue.size();
+
+    return result;
+}
+
+static void report(const char *workload, size_t size, size_t n, const char *implementation, Result result)
+{
+    /* the top-k workload streams 10 * n elements */
+    double operations = (double)(std::strcmp(workload, "topk") == 0 ? 10 * n : n);
+
+    std::printf("%-8s %6lu %10lu  %-22s %10.2f %10.2f", workload, (unsigned long)size, (unsigned long)n,
+                implementation, result.nanoseconds / operations, result.comparisons / operations);
+#ifdef HEAP_STATS
+    std::printf(" %10.2f", result.moves / operations);
+#endif
+    std::printf("   (checksum %lu)\n", (unsigned long)result.checksum);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *workloads[] = {"push", "pop", "mixed", "heapify", "topk"};
+    size_t maxSize = argc > 1 ? (size_t)std::strtoul(argv[1], NULL, 10) : 1000000;
+    size_t n, w, i;
+
+    if (maxSize > 100000000)
+    {
+        maxSize = 100000000;
+    }
+
+    keys.resize(1 << 20);
+    std::srand(42);
+
+    for (i = 0; i < keys.size(); i++)
+    {
+        keys[i] = ((unsigned int)std::rand() << 16) ^ (unsigned int)std::rand();
+    }
+
+    std::printf("%-8s %6s %10s  %-22s %10s %10s", "workload", "bytes", "n", "implementation", "ns/op", "cmp/op");
+#ifdef HEAP_STATS
+    std::printf(" %10s", "moves/op");
+#endif
+    std::printf("\n");
+
+    for (w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++)
+    {
+        for (n = 1000; n <= maxSize; n *= 10)
+        {
+            report(workloads[w], 4, n, "heap.h binary", run_Binary4(workloads[w], n));
+            report(workloads[w], 4, n, "heap.h 16-ary", run_Dary4(workloads[w], n));
+            report(workloads[w], 4, n, "std::priority_queue", run_std<Element4>(workloads[w], n));
+            report(workloads[w], 16, n, "heap.h binary", run_Binary16(workloads[w], n));
+            report(workloads[w], 16, n, "heap.h 4-ary", run_Dary16(workloads[w], n));
+            report(workloads[w], 16, n, "std::priority_queue", run_std<Element16>(workloads[w], n));
+            report(workloads[w], 64, n, "heap.h binary", run_Binary64(workloads[w], n));
+            report(workloads[w], 64, n, "heap.h 4-ary", run_Dary64(workloads[w], n));
+            report(workloads[w], 64, n, "std::priority_queue", run_std<Element64>(workloads[w], n));
+        }
+    }
+
+    return 0;
+}
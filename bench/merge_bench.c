@@ -0,0 +1,193 @@
+/*
+ * Benchmark of the merge.h loser tree against merging with a heap.h heap.
+ *
+ * Build and run from the repository root:
+ * cc -O2 -DHEAP_STATS -I. bench/merge_bench.c -o merge_bench && ./merge_bench [total_size]
+ *
+ * total_size (default 10M) random ints are split into k sorted runs in memory, k from 2 to 512.
+ * The heap merge pushes the head of every run and pops and pushes once per output element,
+ * the loser tree merge reads batches of 4096 elements into a caller buffer.
+ * Reported is the time per output element, the throughput and the comparisons per element of the heap.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "merge.h"
+
+#define BATCH_SIZE 4096
+
+typedef struct Head
+{
+    int value;
+    size_t run;
+} Head;
+
+int int_compare(int a, int b)
+{
+    return (a < b) - (a > b);
+}
+
+int head_compare(Head a, Head b)
+{
+    return (a.value < b.value) - (a.value > b.value);
+}
+
+DECL_DHEAP(Head, Head, head_compare, 4)
+DECL_MERGE(int, int, int_compare)
+
+static unsigned long seed = 1;
+
+static int random_int(void)
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+
+    return (int)(seed >> 1);
+}
+
+static double now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+static int qsort_compare(const void *a, const void *b)
+{
+    return (*(const int *)a > *(const int *)b) - (*(const int *)a < *(const int *)b);
+}
+
+/* returns ns per output element, comparisons per element are stored in comparisons */
+static double run_heap(const int *data, const size_t *starts, size_t k, int *output, double *comparisons)
+{
+    Head_Heap *heap = Head_heap_create(k);
+    size_t *positions = (size_t *)malloc(sizeof(size_t) * k);
+    size_t size = 0;
+    double start;
+    Head head;
+    size_t i;
+
+    start = now();
+
+    for (i = 0; i < k; i++)
+    {
+        positions[i] = starts[i];
+
+        if (positions[i] < starts[i + 1])
+        {
+            head.value = data[positions[i]];
+            head.run = i;
+            Head_heap_push(heap, head);
+        }
+    }
+
+    while (heap->size > 0)
+    {
+        head = Head_heap_top(heap);
+        output[size++] = head.value;
+
+        if (++positions[head.run] < starts[head.run + 1])
+        {
+            head.value = data[positions[head.run]];
+            Head_heap_replace_top(heap, head);
+        }
+        else
+        {
+            Head_heap_pop(heap);
+        }
+    }
+
+    start = (now() - start) / size;
+#ifdef HEAP_STATS
+    *comparisons = heap->stats.comparisons / (double)size;
+#else
+    *comparisons = 0;
+#endif
+    free(positions);
+    Head_heap_destroy(heap);
+
+    return start;
+}
+
+static double run_merge(const int *data, const size_t *starts, size_t k, int *output)
+{
+    int_MergeRun *runs = (int_MergeRun *)malloc(sizeof(int_MergeRun) * k);
+    int_Merge *merge;
+    size_t size = 0;
+    size_t read;
+    double start;
+    size_t i;
+
+    start = now();
+
+    for (i = 0; i < k; i++)
+    {
+        int_merge_run_array(&runs[i], data + starts[i], starts[i + 1] - starts[i]);
+    }
+
+    merge = int_merge_create(runs, k);
+
+    do
+    {
+        read = int_merge_read(merge, output + size, BATCH_SIZE);
+        size += read;
+    } while (read == BATCH_SIZE);
+
+    start = (now() - start) / size;
+    int_merge_destroy(merge);
+    free(runs);
+
+    return start;
+}
+
+int main(int argc, char **argv)
+{
+    size_t total = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 10000000;
+    int *data = (int *)malloc(sizeof(int) * total);
+    int *output = (int *)malloc(sizeof(int) * (total + BATCH_SIZE));
+    size_t *starts = (size_t *)malloc(sizeof(size_t) * 513);
+    double heap, merge, comparisons;
+    size_t i, k;
+
+    if (data == NULL || output == NULL || starts == NULL)
+    {
+        printf("[Error]: could not allocate memory for the benchmark\nTerminating...\n");
+        exit(1);
+    }
+
+    printf("%6s %12s %12s %14s %12s\n", "k", "heap ns/op", "heap cmp", "merge ns/op", "merge MB/s");
+
+    for (k = 2; k <= 512; k *= 4)
+    {
+        for (i = 0; i < total; i++)
+        {
+            data[i] = random_int();
+        }
+
+        for (i = 0; i <= k; i++)
+        {
+            starts[i] = total / k * i;
+        }
+
+        starts[k] = total;
+
+        for (i = 0; i < k; i++)
+        {
+            qsort(data + starts[i], starts[i + 1] - starts[i], sizeof(int), qsort_compare);
+        }
+
+        heap = run_heap(data, starts, k, output, &comparisons);
+        merge = run_merge(data, starts, k, output);
+        printf("%6lu %12.2f %12.2f %14.2f %12.1f\n", (unsigned long)k, heap, comparisons, merge,
+               sizeof(int) * 1e3 / merge);
+    }
+
+    free(data);
+    free(output);
+    free(starts);
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Scaling benchmark of multiqueue.h against a heap.h heap behind a global mutex.
+ *
+ * Build and run from the repository root:
+ * cc -O2 -I. bench/multiqueue_bench.c -o multiqueue_bench -lpthread && ./multiqueue_bench [max_threads]
+ *
+ * The queue is filled with 1M elements, then 1 to max_threads threads (default 16) repeatedly
+ * pop an element and push it back with a larger key, like workers of a scheduler.
+ * Reported is the throughput in million operations (push or pop) per second.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "multiqueue.h"
+
+#define PREFILL 1000000
+#define OPERATIONS 4000000
+
+int int_compare(unsigned int a, unsigned int b)
+{
+    return (a < b) - (a > b);
+}
+
+DECL_HEAP(unsigned int, UInt, int_compare)
+DECL_MULTIQUEUE(unsigned int, UInt, int_compare)
+
+typedef struct Worker
+{
+    pthread_t thread;
+    unsigned long seed;
+    size_t operations;
+    int mode;
+} Worker;
+
+/* modes of the benchmark */
+#define MODE_LOCKED_HEAP 0
+#define MODE_MULTIQUEUE 1
+#define MODE_MULTIQUEUE_STRICT 2
+
+static UInt_Heap *lockedHeap;
+static pthread_mutex_t heapLock = PTHREAD_MUTEX_INITIALIZER;
+static UInt_MultiQueue *multiQueue;
+
+static void *work(void *argument)
+{
+    Worker *worker = (Worker *)argument;
+    unsigned int key;
+    size_t i;
+    int popped;
+
+    for (i = 0; i < worker->operations; i += 2)
+    {
+        if (worker->mode == MODE_LOCKED_HEAP)
+        {
+            pthread_mutex_lock(&heapLock);
+            key = UInt_heap_pop(lockedHeap);
+            UInt_heap_push(lockedHeap, key + 1 + (unsigned int)(i & 1023));
+            pthread_mutex_unlock(&heapLock);
+        }
+        else
+        {
+            if (worker->mode == MODE_MULTIQUEUE)
+            {
+                popped = UInt_multiqueue_pop(multiQueue, &key, &worker->seed);
+            }
+            else
+            {
+                popped = UInt_multiqueue_pop_strict(multiQueue, &key);
+            }
+
+            if (popped)
+            {
+                UInt_multiqueue_push(multiQueue, key + 1 + (unsigned int)(i & 1023), &worker->seed);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static double run(int mode, size_t threads)
+{
+    Worker *workers = (Worker *)malloc(sizeof(Worker) * threads);
+    unsigned long seed = 1;
+    struct timespec start, end;
+    size_t i;
+
+    if (mode == MODE_LOCKED_HEAP)
+    {
+        lockedHeap = UInt_heap_create(PREFILL);
+
+        for (i = 0; i < PREFILL; i++)
+        {
+            UInt_heap_push(lockedHeap, (unsigned int)(i * 2654435761UL));
+        }
+    }
+    else
+    {
+        multiQueue = UInt_multiqueue_create(threads, 2, PREFILL);
+
+        for (i = 0; i < PREFILL; i++)
+        {
+            UInt_multiqueue_push(multiQueue, (unsigned int)(i * 2654435761UL), &seed);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0; i < threads; i++)
+    {
+        workers[i].seed = i + 1;
+        workers[i].operations = OPERATIONS / threads;
+        workers[i].mode = mode;
+        pthread_create(&workers[i].thread, NULL, work, &workers[i]);
+    }
+
+    for (i = 0; i < threads; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (mode == MODE_LOCKED_HEAP)
+    {
+        UInt_heap_destroy(lockedHeap);
+    }
+    else
+    {
+        UInt_multiqueue_destroy(multiQueue);
+    }
+
+    free(workers);
+
+    return OPERATIONS / ((end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3);
+}
+
+int main(int argc, char **argv)
+{
+    size_t maxThreads = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 16;
+    size_t threads;
+
+    printf("%7s %18s %18s %18s\n", "threads", "mutex heap Mop/s", "multiqueue Mop/s", "strict Mop/s");
+
+    for (threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        printf("%7lu", (unsigned long)threads);
+        printf(" %18.2f", run(MODE_LOCKED_HEAP, threads));
+        printf(" %18.2f", run(MODE_MULTIQUEUE, threads));
+        printf(" %18.2f\n", run(MODE_MULTIQUEUE_STRICT, threads));
+    }
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Benchmark of radix_heap.h against heap.h on monotone workloads.
+ *
+ * Build and run from the repository root:
+ * cc -O2 -DNDEBUG -DHEAP_STATS -I. bench/radix_heap_bench.c -o radix_heap_bench && ./radix_heap_bench [max_size]
+ *
+ * Like in an event simulation or Dijkstra's algorithm, a heap with n elements repeatedly
+ * pops the smallest key k and pushes k + delta for a random delta below a maximum key distance C.
+ * Heap sizes start at 1K and grow by a factor of 10 up to max_size (default 1M),
+ * reported is the time per pop + push pair and the comparisons per pair of the binary heap.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "radix_heap.h"
+
+typedef struct Event
+{
+    unsigned long key;
+    unsigned long value;
+} Event;
+
+int event_compare(Event a, Event b)
+{
+    return (a.key < b.key) - (a.key > b.key);
+}
+
+DECL_HEAP(Event, Event, event_compare)
+DECL_RADIX_HEAP(unsigned long, unsigned long, Event)
+
+static unsigned long seed = 1;
+
+/* returns 24 random bits */
+static unsigned long random_bits(void)
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+
+    return seed >> 8;
+}
+
+static unsigned long random_delta(unsigned long range)
+{
+    /* two draws, a single one would limit the deltas to 2^24 */
+    unsigned long value = random_bits() << 24;
+
+    return (value | random_bits()) % range;
+}
+
+static double now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+/* returns ns per pop + push pair, comparisons per pair are stored in comparisons */
+static double run_binary(size_t n, unsigned long range, double *comparisons)
+{
+    Event_Heap *heap = Event_heap_create(n);
+    Event event;
+    double start;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        event.key = random_delta(range);
+        event.value = i;
+        Event_heap_push(heap, event);
+    }
+
+    HEAP_STATS_RESET(heap);
+    start = now();
+
+    for (i = 0; i < 10 * n; i++)
+    {
+        event = Event_heap_pop(heap);
+        event.key += random_delta(range);
+        Event_heap_push(heap, event);
+    }
+
+    start = (now() - start) / (10.0 * n);
+#ifdef HEAP_STATS
+    *comparisons = heap->stats.comparisons / (10.0 * n);
+#else
+    *comparisons = 0;
+#endif
+    Event_heap_destroy(heap);
+
+    return start;
+}
+
+static double run_radix(size_t n, unsigned long range)
+{
+    Event_RadixHeap *heap = Event_radix_heap_create(n);
+    unsigned long value;
+    double start;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        Event_radix_heap_push(heap, random_delta(range), i);
+    }
+
+    start = now();
+
+    for (i = 0; i < 10 * n; i++)
+    {
+        value = Event_radix_heap_pop(heap);
+        Event_radix_heap_push(heap, heap->last + random_delta(range), value);
+    }
+
+    start = (now() - start) / (10.0 * n);
+    Event_radix_heap_destroy(heap);
+
+    return start;
+}
+
+int main(int argc, char **argv)
+{
+    static const unsigned long ranges[] = {1000UL, 1000000UL, 1000000000UL};
+    size_t maxSize = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 1000000;
+    double binary, radix, comparisons;
+    size_t n, r;
+
+    printf("%10s %12s %14s %12s %14s\n", "n", "C", "binary ns/op", "binary cmp", "radix ns/op");
+
+    for (n = 1000; n <= maxSize; n *= 10)
+    {
+        for (r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+        {
+            binary = run_binary(n, ranges[r], &comparisons);
+            radix = run_radix(n, ranges[r]);
+            printf("%10lu %12lu %14.2f %12.2f %14.2f\n", (unsigned long)n, ranges[r], binary, comparisons, radix);
+        }
+    }
+
+    return 0;
+}
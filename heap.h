@@ -1,42 +1,222 @@
 /* Based on "Type-safe generic data structures in C" by Ian Fisher (https://iafisher.com/blog/2020/06/type-safe-generics-in-c) */
 
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
+/*
+ * Size in bytes the element storage of d-ary heaps is aligned to.
+ * May be defined before including this file to match the target machine.
+ */
+#ifndef HEAP_CACHE_LINE_SIZE
+#define HEAP_CACHE_LINE_SIZE 64
+#endif
+
+/* Rounds pointer up to the next multiple of HEAP_CACHE_LINE_SIZE. */
+#define HEAP_CACHE_LINE_ALIGN(pointer)                                                                     \
+    (((size_t)(pointer) + HEAP_CACHE_LINE_SIZE - 1) & ~(size_t)(HEAP_CACHE_LINE_SIZE - 1))
+
+/*
+ * Index computations for a heap with "arity" children per element.
+ * The top element is stored at index arity - 1, so the children of every element
+ * start at a multiple of arity and each group of siblings shares one aligned block.
+ * For arity 2 this is the classic layout: top at 1, children of n at 2n and 2n+1.
+ */
+#define HEAP_TOP_INDEX(arity) ((arity) - 1)
+#define HEAP_LAST_INDEX(heap, arity) ((heap)->size + (arity) - 2)
+#define HEAP_FIRST_CHILD_INDEX(index, arity) ((arity) * ((index) + 2 - (arity)))
+#define HEAP_PARENT_INDEX(index, arity) ((index) / (arity) + (arity) - 2)
+
+/*
+ * Compile with HEAP_STATS defined to count the comparisons and element moves of every heap
+ * in heap->stats, together with the maximum number of levels (max_depth) an element was
+ * sorted up or down at once. Without HEAP_STATS the heaps contain no counters.
+ */
+#ifdef HEAP_STATS
+typedef struct HeapStats
+{
+    unsigned long comparisons;
+    unsigned long moves;
+    unsigned long max_depth;
+} HeapStats;
+
+#define HEAP_STATS_FIELD HeapStats stats;
+#define HEAP_STATS_RESET(heap) memset(&(heap)->stats, 0, sizeof(HeapStats))
+#define HEAP_STATS_ADD(heap, counter, count) ((heap)->stats.counter += (count))
+#define HEAP_STATS_DEPTH(heap, depth)                                                                      \
+    ((heap)->stats.max_depth < (depth) ? (void)((heap)->stats.max_depth = (depth)) : (void)0)
+#else
+#define HEAP_STATS_FIELD
+#define HEAP_STATS_RESET(heap) ((void)0)
+#define HEAP_STATS_ADD(heap, counter, count) ((void)0)
+#define HEAP_STATS_DEPTH(heap, depth) ((void)(depth))
+#endif
+
+/*
+ * Ways to pass elements to type_compare: HEAP_BY_VALUE for int type_compare(type a, type b),
+ * HEAP_BY_POINTER for int type_compare(const type *a, const type *b), which avoids copying large elements.
+ */
+#define HEAP_BY_VALUE(type_compare, a, b) type_compare(a, b)
+#define HEAP_BY_POINTER(type_compare, a, b) type_compare(&(a), &(b))
+
+/* Calls type_compare on a and b, counted as a comparison of heap if HEAP_STATS is defined. */
+#define HEAP_COMPARE(heap, compare_by, type_compare, a, b)                                                 \
+    (HEAP_STATS_ADD(heap, comparisons, 1), compare_by(type_compare, a, b))
+
+/*
+ * Default allocation functions of heaps, used by DECL_HEAP and DECL_DHEAP.
+ * Custom allocation functions for DECL_HEAP_ALLOC and DECL_DHEAP_ALLOC must have the same parameters:
+ * the context pointer passed to type_name_heap_create_in and the size in bytes of the affected block.
+ */
+#define HEAP_DEFAULT_ALLOC(context, size) malloc(size)
+#define HEAP_DEFAULT_REALLOC(context, block, old_size, new_size) realloc(block, new_size)
+#define HEAP_DEFAULT_FREE(context, block, size) free(block)
+
+/*
+ * Capacity of a heap that has to grow from a capacity of 0.
+ * Heaps double their capacity whenever they run out of space.
+ */
+#ifndef HEAP_MIN_CAPACITY
+#define HEAP_MIN_CAPACITY 8
+#endif
 
 /*
  * Declare a min heap with elements of type "type".
  * All declared functions will have the signature type_name_heap_FUNCTION.
  * The heap struct will have the signature type_name_Heap.
  * type_compare should return 0 if elements are equal, <0 if first element is bigger, >0 otherwise.
- * 
+ *
  * WARNING: DECL_HEAP with a specific type_name may only be used once in a program.
  * Recommended usage:
  * #ifndef TYPE_NAME_HEAP
  * #define TYPE_NAME_HEAP
  * DECL_HEAP(type, type_name, type_compare)
  * #endif
- * 
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ */
+#define DECL_HEAP(type, type_name, type_compare) DECL_DHEAP(type, type_name, type_compare, 2)
+
+/*
+ * Declare a d-ary min heap with elements of type "type" and "arity" children per element.
+ * The declared struct and functions are the same as for DECL_HEAP, which is DECL_DHEAP with arity 2.
+ * The element storage is aligned to HEAP_CACHE_LINE_SIZE, so if arity * sizeof(type) equals
+ * the cache line size, all children of an element are read with a single cache line.
+ * E.g. arity 4 for 16 byte elements or arity 8 for 8 byte elements.
+ *
+ * WARNING: DECL_HEAP or DECL_DHEAP with a specific type_name may only be used once in a program.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ * @param arity number of children per element, at least 2
+ */
+#define DECL_DHEAP(type, type_name, type_compare, arity)                                                   \
+    DECL_DHEAP_ALLOC(type, type_name, type_compare, arity,                                                 \
+                     HEAP_DEFAULT_ALLOC, HEAP_DEFAULT_REALLOC, HEAP_DEFAULT_FREE)
+
+/*
+ * Declare a min heap like DECL_HEAP, which allocates all memory with the given functions
+ * instead of malloc, realloc and free, e.g. from an arena or a pool.
+ * The functions (or function-like macros) are called as:
+ * void *heap_alloc(void *context, size_t size)
+ * void *heap_realloc(void *context, void *block, size_t old_size, size_t new_size)
+ * void heap_free(void *context, void *block, size_t size)
+ * where context is the pointer passed to type_name_heap_create_in (NULL for type_name_heap_create).
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ * @param heap_alloc
+ * @param heap_realloc
+ * @param heap_free
+ */
+#define DECL_HEAP_ALLOC(type, type_name, type_compare, heap_alloc, heap_realloc, heap_free)                \
+    DECL_DHEAP_ALLOC(type, type_name, type_compare, 2, heap_alloc, heap_realloc, heap_free)
+
+/*
+ * Declare a d-ary min heap like DECL_DHEAP, which allocates all memory with the given functions.
+ * See DECL_HEAP_ALLOC for the parameters of the functions.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ * @param arity number of children per element, at least 2
+ * @param heap_alloc
+ * @param heap_realloc
+ * @param heap_free
+ */
+#define DECL_DHEAP_ALLOC(type, type_name, type_compare, arity, heap_alloc, heap_realloc, heap_free)        \
+    DECL_DHEAP_GENERIC(type, type_name, type_compare, HEAP_BY_VALUE, arity, heap_alloc, heap_realloc, heap_free)
+
+/*
+ * Declare a min heap like DECL_HEAP, whose type_compare gets pointers to the elements:
+ * int type_compare(const type *a, const type *b), with the same results as for DECL_HEAP.
+ * Use it for large element types, which would be copied for every comparison otherwise.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ */
+#define DECL_HEAP_PTR(type, type_name, type_compare) DECL_DHEAP_PTR(type, type_name, type_compare, 2)
+
+/*
+ * Declare a d-ary min heap like DECL_DHEAP, whose type_compare gets pointers to the elements.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ * @param arity number of children per element, at least 2
+ */
+#define DECL_DHEAP_PTR(type, type_name, type_compare, arity)                                               \
+    DECL_DHEAP_GENERIC(type, type_name, type_compare, HEAP_BY_POINTER, arity,                              \
+                       HEAP_DEFAULT_ALLOC, HEAP_DEFAULT_REALLOC, HEAP_DEFAULT_FREE)
+
+/*
+ * Declare a heap with all options, the other DECL_*HEAP* macros are shortcuts for it.
+ *
  * @param type
  * @param type_name
  * @param type_compare
+ * @param compare_by HEAP_BY_VALUE or HEAP_BY_POINTER, see DECL_HEAP_PTR
+ * @param arity number of children per element, at least 2
+ * @param heap_alloc see DECL_HEAP_ALLOC
+ * @param heap_realloc
+ * @param heap_free
  */
-#define DECL_HEAP(type, type_name, type_compare)                                                           \
+#define DECL_DHEAP_GENERIC(type, type_name, type_compare, compare_by, arity,                               \
+                           heap_alloc, heap_realloc, heap_free)                                            \
+    /* fails to compile (negative array size) if arity is less than 2,                                     \
+       which would make the index computations underflow and the sort loops never stop */                  \
+    typedef char type_name##_HeapArityCheck[(arity) >= 2 ? 1 : -1];                                        \
+                                                                                                           \
     typedef struct type_name##_Heap                                                                        \
     {                                                                                                      \
         size_t capacity;                                                                                   \
         size_t size;                                                                                       \
         type *elements;                                                                                    \
+        void *block;                                                                                       \
+        size_t block_size;                                                                                 \
+        void *context;                                                                                     \
+        HEAP_STATS_FIELD                                                                                   \
     } type_name##_Heap;                                                                                    \
                                                                                                            \
     /*                                                                                                     \
-     * Instanciates a dynamically allocated heap struct and returns a pointer to it.                       \
+     * Instanciates a heap struct with memory from the allocation functions and returns a pointer to it.   \
      *                                                                                                     \
+     * @param void *context passed to the allocation functions                                             \
      * @param size_t capacity                                                                              \
      * @return Heap *heap                                                                                  \
      */                                                                                                    \
-    type_name##_Heap *type_name##_heap_create(size_t capacity)                                             \
+    type_name##_Heap *type_name##_heap_create_in(void *context, size_t capacity)                           \
     {                                                                                                      \
-        type_name##_Heap *heap = malloc(sizeof(type_name##_Heap));                                         \
+        type_name##_Heap *heap = (type_name##_Heap *)heap_alloc(context, sizeof(type_name##_Heap));        \
                                                                                                            \
         if (heap == NULL)                                                                                  \
         {                                                                                                  \
@@ -44,22 +224,39 @@
         }                                                                                                  \
                                                                                                            \
         /* Note: To easily compute parent and child indecies of elements,                                  \
-           heap->elements[0] is not used, the top element is at index 1. */                                \
-        heap->elements = malloc(sizeof(type) * (capacity + 1));                                            \
+           heap->elements[0 ... arity - 2] are not used, the top element is at index arity - 1.            \
+           The block is over-allocated so that elements can start at a cache line boundary. */             \
+        heap->block_size = sizeof(type) * (capacity + (arity) - 1) + HEAP_CACHE_LINE_SIZE - 1;             \
+        heap->block = heap_alloc(context, heap->block_size);                                               \
                                                                                                            \
-        if (heap->elements == NULL)                                                                        \
+        if (heap->block == NULL)                                                                           \
         {                                                                                                  \
-            free(heap);                                                                                    \
+            heap_free(context, heap, sizeof(type_name##_Heap));                                            \
                                                                                                            \
             return NULL;                                                                                   \
         }                                                                                                  \
                                                                                                            \
+        heap->elements = (type *)HEAP_CACHE_LINE_ALIGN(heap->block);                                       \
         heap->size = 0;                                                                                    \
         heap->capacity = capacity;                                                                         \
+        heap->context = context;                                                                           \
+        HEAP_STATS_RESET(heap);                                                                            \
                                                                                                            \
         return heap;                                                                                       \
     }                                                                                                      \
                                                                                                            \
+    /*                                                                                                     \
+     * Instanciates a dynamically allocated heap struct and returns a pointer to it.                       \
+     * The heap grows beyond capacity when necessary.                                                      \
+     *                                                                                                     \
+     * @param size_t capacity                                                                              \
+     * @return Heap *heap                                                                                  \
+     */                                                                                                    \
+    type_name##_Heap *type_name##_heap_create(size_t capacity)                                             \
+    {                                                                                                      \
+        return type_name##_heap_create_in(NULL, capacity);                                                 \
+    }                                                                                                      \
+                                                                                                           \
     /*                                                                                                     \
      * Deallocates the heap struct and its elements.                                                       \
      *                                                                                                     \
@@ -67,14 +264,117 @@
      */                                                                                                    \
     void type_name##_heap_destroy(type_name##_Heap *heap)                                                  \
     {                                                                                                      \
-        free(heap->elements);                                                                              \
-        free(heap);                                                                                        \
+        heap_free(heap->context, heap->block, heap->block_size);                                           \
+        heap_free(heap->context, heap, sizeof(type_name##_Heap));                                          \
                                                                                                            \
         heap = NULL;                                                                                       \
                                                                                                            \
         return;                                                                                            \
     }                                                                                                      \
                                                                                                            \
+    /*                                                                                                     \
+     * Changes the capacity of the heap, which has to be at least the size of the heap.                    \
+     * The elements keep their cache line alignment if the block is moved.                                 \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @param size_t capacity                                                                              \
+     * @return int 0 on success, -1 if the memory could not be allocated (the heap is unchanged)           \
+     */                                                                                                    \
+    int type_name##_heap_resize(type_name##_Heap *heap, size_t capacity)                                   \
+    {                                                                                                      \
+        size_t blockSize = sizeof(type) * (capacity + (arity) - 1) + HEAP_CACHE_LINE_SIZE - 1;             \
+        size_t offset = (size_t)((char *)heap->elements - (char *)heap->block);                            \
+        char *block = (char *)heap_realloc(heap->context, heap->block, heap->block_size, blockSize);       \
+        type *elements;                                                                                    \
+                                                                                                           \
+        if (block == NULL)                                                                                 \
+        {                                                                                                  \
+            return -1;                                                                                     \
+        }                                                                                                  \
+                                                                                                           \
+        elements = (type *)HEAP_CACHE_LINE_ALIGN(block);                                                   \
+                                                                                                           \
+        if ((char *)elements != block + offset)                                                            \
+        {                                                                                                  \
+            /* the realloced block has a different alignment, move the elements to the aligned position */ \
+            memmove(elements, block + offset, sizeof(type) * (heap->size + (arity) - 1));                  \
+        }                                                                                                  \
+                                                                                                           \
+        heap->block = block;                                                                               \
+        heap->block_size = blockSize;                                                                      \
+        heap->elements = elements;                                                                         \
+        heap->capacity = capacity;                                                                         \
+                                                                                                           \
+        return 0;                                                                                          \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Makes sure the heap can hold at least capacity elements without growing.                            \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @param size_t capacity                                                                              \
+     * @return int 0 on success, -1 if the memory could not be allocated                                   \
+     */                                                                                                    \
+    int type_name##_heap_reserve(type_name##_Heap *heap, size_t capacity)                                  \
+    {                                                                                                      \
+        if (capacity <= heap->capacity)                                                                    \
+        {                                                                                                  \
+            return 0;                                                                                      \
+        }                                                                                                  \
+                                                                                                           \
+        return type_name##_heap_resize(heap, capacity);                                                    \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Reduces the capacity of the heap to its size.                                                       \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @return int 0 on success, -1 if the memory could not be allocated                                   \
+     */                                                                                                    \
+    int type_name##_heap_shrink_to_fit(type_name##_Heap *heap)                                             \
+    {                                                                                                      \
+        if (heap->size == heap->capacity)                                                                  \
+        {                                                                                                  \
+            return 0;                                                                                      \
+        }                                                                                                  \
+                                                                                                           \
+        return type_name##_heap_resize(heap, heap->size);                                                  \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Makes sure count more elements fit into the heap, doubling its capacity if necessary.               \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @param size_t count                                                                                 \
+     */                                                                                                    \
+    void type_name##_heap_grow(type_name##_Heap *heap, size_t count)                                       \
+    {                                                                                                      \
+        size_t capacity = heap->capacity;                                                                  \
+                                                                                                           \
+        if (heap->size + count <= capacity)                                                                \
+        {                                                                                                  \
+            return;                                                                                        \
+        }                                                                                                  \
+                                                                                                           \
+        if (capacity < HEAP_MIN_CAPACITY)                                                                  \
+        {                                                                                                  \
+            capacity = HEAP_MIN_CAPACITY;                                                                  \
+        }                                                                                                  \
+                                                                                                           \
+        while (capacity < heap->size + count)                                                              \
+        {                                                                                                  \
+            capacity *= 2;                                                                                 \
+        }                                                                                                  \
+                                                                                                           \
+        if (type_name##_heap_resize(heap, capacity) != 0)                                                  \
+        {                                                                                                  \
+            printf("[Error]: could not allocate memory for heap elements\nTerminating...\n");              \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
     /*                                                                                                     \
      * Sorting from the last heap element upwards.                                                         \
      *                                                                                                     \
@@ -86,20 +386,23 @@
         if (heap->size > 1)                                                                                \
         {                                                                                                  \
             /* start at the bottom */                                                                      \
-            size_t currentIndex = heap->size;                                                              \
+            size_t currentIndex = HEAP_LAST_INDEX(heap, arity);                                            \
             size_t parentIndex;                                                                            \
+            size_t depth = 0;                                                                              \
             /* temporarily save last element as the one to be sorted up */                                 \
             type sortElement = heap->elements[currentIndex];                                               \
                                                                                                            \
-            while (currentIndex > 1)                                                                       \
+            while (currentIndex > HEAP_TOP_INDEX(arity))                                                   \
             {                                                                                              \
-                parentIndex = currentIndex / 2;                                                            \
+                parentIndex = HEAP_PARENT_INDEX(currentIndex, arity);                                      \
                                                                                                            \
-                if (type_compare(heap->elements[parentIndex], sortElement) < 0)                            \
+                if (HEAP_COMPARE(heap, compare_by, type_compare,                                           \
+                                 heap->elements[parentIndex], sortElement) < 0)                            \
                 {                                                                                          \
                     /* move parent element down if it's greater than the current one */                    \
                     heap->elements[currentIndex] = heap->elements[parentIndex];                            \
                     currentIndex = parentIndex;                                                            \
+                    depth++;                                                                               \
                 }                                                                                          \
                 else                                                                                       \
                 {                                                                                          \
@@ -110,87 +413,254 @@
                                                                                                            \
             /* insert sortElement at determined position */                                                \
             heap->elements[currentIndex] = sortElement;                                                    \
+            HEAP_STATS_ADD(heap, moves, depth + 1);                                                        \
+            HEAP_STATS_DEPTH(heap, depth);                                                                 \
         }                                                                                                  \
                                                                                                            \
         return;                                                                                            \
     }                                                                                                      \
                                                                                                            \
     /*                                                                                                     \
-     * Sorting from the top heap element downwards.                                                        \
+     * Sorting from the element at index downwards, bottom-up:                                             \
+     * the hole at index is first moved down to the bottom along the smallest children,                    \
+     * then the element is sorted up from there. Elements removed from the top usually belong              \
+     * near the bottom, so this needs about arity - 1 instead of arity comparisons per level.              \
      *                                                                                                     \
      * @param Heap *heap                                                                                   \
+     * @param size_t index                                                                                 \
      */                                                                                                    \
-    void type_name##_heap_sort_down(type_name##_Heap *heap)                                                \
+    void type_name##_heap_sort_down_from(type_name##_Heap *heap, size_t index)                             \
     {                                                                                                      \
         /* sorting is only necessary if there is more than one element */                                  \
         if (heap->size > 1)                                                                                \
         {                                                                                                  \
-            /* start at the top */                                                                         \
-            size_t currentIndex = 1;                                                                       \
-            size_t leftChildIndex, rightChildIndex;                                                        \
-            /* temporarily save top element as the one to be sorted down */                                \
+            /* start at index */                                                                           \
+            size_t currentIndex = index;                                                                   \
+            size_t lastIndex = HEAP_LAST_INDEX(heap, arity);                                               \
+            size_t childIndex, lastChildIndex, smallestChildIndex, parentIndex;                            \
+            size_t depth = 0, height = 0;                                                                  \
+            /* temporarily save the element at index as the one to be sorted down */                       \
             type sortElement = heap->elements[currentIndex];                                               \
                                                                                                            \
-            while (1)                                                                                      \
+            /* children of element n are stored next to each other,                                        \
+               starting at arity * (n + 2 - arity) */                                                      \
+            while ((childIndex = HEAP_FIRST_CHILD_INDEX(currentIndex, arity)) <= lastIndex)                \
             {                                                                                              \
-                /* for element n: left child at 2n, right child at 2n+1 */                                 \
-                leftChildIndex = 2 * currentIndex;                                                         \
-                rightChildIndex = leftChildIndex + 1;                                                      \
+                lastChildIndex = childIndex + (arity) - 1;                                                 \
                                                                                                            \
-                if (leftChildIndex <= heap->size)                                                          \
+                if (lastChildIndex > lastIndex)                                                            \
                 {                                                                                          \
-                    /* left child exists */                                                                \
-                    if (rightChildIndex <= heap->size &&                                                   \
-                        type_compare(sortElement, heap->elements[rightChildIndex]) < 0 &&                  \
-                        type_compare(heap->elements[rightChildIndex], heap->elements[leftChildIndex]) > 0) \
-                    {                                                                                      \
-                        /* right child exists, is smaller than sortElement and left child                  \
-                           => move right child up, move on from right child index */                       \
-                        heap->elements[currentIndex] = heap->elements[rightChildIndex];                    \
-                        currentIndex = rightChildIndex;                                                    \
-                    }                                                                                      \
-                    else if (type_compare(sortElement, heap->elements[leftChildIndex]) < 0)                \
-                    {                                                                                      \
-                        /* left child is smaller than sortElement                                          \
-                           => move left child up, move on from left child index */                         \
-                        heap->elements[currentIndex] = heap->elements[leftChildIndex];                     \
-                        currentIndex = leftChildIndex;                                                     \
-                    }                                                                                      \
-                    else                                                                                   \
+                    lastChildIndex = lastIndex;                                                            \
+                }                                                                                          \
+                                                                                                           \
+                /* find the smallest of the existing children */                                           \
+                smallestChildIndex = childIndex;                                                           \
+                                                                                                           \
+                for (++childIndex; childIndex <= lastChildIndex; ++childIndex)                             \
+                {                                                                                          \
+                    if (HEAP_COMPARE(heap, compare_by, type_compare,                                       \
+                                     heap->elements[smallestChildIndex], heap->elements[childIndex]) < 0)  \
                     {                                                                                      \
-                        /* currentIndex is correct position for sortElement */                             \
-                        break;                                                                             \
+                        smallestChildIndex = childIndex;                                                   \
                     }                                                                                      \
+                }                                                                                          \
+                                                                                                           \
+                /* move smallest child up without comparing it to sortElement, move on from its index */   \
+                heap->elements[currentIndex] = heap->elements[smallestChildIndex];                         \
+                currentIndex = smallestChildIndex;                                                         \
+                depth++;                                                                                   \
+            }                                                                                              \
+                                                                                                           \
+            /* reached the bottom of the heap, sort sortElement up, but not above index */                 \
+            while (currentIndex > index)                                                                   \
+            {                                                                                              \
+                parentIndex = HEAP_PARENT_INDEX(currentIndex, arity);                                      \
+                                                                                                           \
+                if (HEAP_COMPARE(heap, compare_by, type_compare,                                           \
+                                 heap->elements[parentIndex], sortElement) < 0)                            \
+                {                                                                                          \
+                    /* move parent element down if it's greater than sortElement */                        \
+                    heap->elements[currentIndex] = heap->elements[parentIndex];                            \
+                    currentIndex = parentIndex;                                                            \
+                    height++;                                                                              \
                 }                                                                                          \
                 else                                                                                       \
                 {                                                                                          \
-                    /* reached the top of the heap */                                                      \
+                    /* currentIndex is correct position for sortElement */                                 \
                     break;                                                                                 \
                 }                                                                                          \
             }                                                                                              \
                                                                                                            \
             /* insert sortElement at determined position */                                                \
             heap->elements[currentIndex] = sortElement;                                                    \
+            HEAP_STATS_ADD(heap, moves, depth + height + 1);                                               \
+            HEAP_STATS_DEPTH(heap, depth - height);                                                        \
+        }                                                                                                  \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Sorting from the top heap element downwards.                                                        \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     */                                                                                                    \
+    void type_name##_heap_sort_down(type_name##_Heap *heap)                                                \
+    {                                                                                                      \
+        type_name##_heap_sort_down_from(heap, HEAP_TOP_INDEX(arity));                                      \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Restores the heap order of all elements bottom-up in O(n),                                          \
+     * by sorting down every element that has children, starting with the last one.                        \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     */                                                                                                    \
+    void type_name##_heap_heapify(type_name##_Heap *heap)                                                  \
+    {                                                                                                      \
+        size_t index;                                                                                      \
+                                                                                                           \
+        if (heap->size > 1)                                                                                \
+        {                                                                                                  \
+            /* the parent of the last element is the last element with children */                         \
+            index = HEAP_PARENT_INDEX(HEAP_LAST_INDEX(heap, arity), arity) + 1;                            \
+                                                                                                           \
+            while (index > HEAP_TOP_INDEX(arity))                                                          \
+            {                                                                                              \
+                type_name##_heap_sort_down_from(heap, --index);                                            \
+            }                                                                                              \
         }                                                                                                  \
                                                                                                            \
         return;                                                                                            \
     }                                                                                                      \
                                                                                                            \
     /*                                                                                                     \
-     * Inserts a new element into the heap.                                                                \
+     * Instanciates a heap with a copy of the given elements in O(n).                                      \
+     * The capacity is raised to size if it is smaller.                                                    \
+     *                                                                                                     \
+     * @param const type *array                                                                            \
+     * @param size_t size number of elements in array                                                      \
+     * @param size_t capacity                                                                              \
+     * @return Heap *heap                                                                                  \
+     */                                                                                                    \
+    type_name##_Heap *type_name##_heap_create_from_array(const type *array, size_t size, size_t capacity)  \
+    {                                                                                                      \
+        type_name##_Heap *heap = type_name##_heap_create(capacity > size ? capacity : size);               \
+                                                                                                           \
+        if (heap == NULL)                                                                                  \
+        {                                                                                                  \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        memcpy(heap->elements + HEAP_TOP_INDEX(arity), array, sizeof(type) * size);                        \
+        HEAP_STATS_ADD(heap, moves, size);                                                                 \
+        heap->size = size;                                                                                 \
+        type_name##_heap_heapify(heap);                                                                    \
+                                                                                                           \
+        return heap;                                                                                       \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Instanciates a heap that takes ownership of buffer without copying its elements, in O(n).           \
+     * buffer has to be allocated with heap_alloc (malloc for DECL_HEAP) with a NULL context               \
+     * and hold capacity + arity - 1 elements,                                                             \
+     * the size elements to adopt are expected at buffer[arity - 1 ... size + arity - 2]                   \
+     * (i.e. starting at buffer[1] for DECL_HEAP). buffer is freed by type_name_heap_destroy.              \
+     * buffer is used as it is, so the elements are only aligned to HEAP_CACHE_LINE_SIZE if buffer is,     \
+     * e.g. from posix_memalign or aligned_alloc, until the heap grows and aligns them.                    \
+     *                                                                                                     \
+     * @param type *buffer                                                                                 \
+     * @param size_t size number of elements in buffer                                                     \
+     * @param size_t capacity number of elements buffer has room for, at least size                        \
+     * @return Heap *heap NULL if size is larger than capacity or the memory could not be allocated        \
+     */                                                                                                    \
+    type_name##_Heap *type_name##_heap_adopt_array(type *buffer, size_t size, size_t capacity)             \
+    {                                                                                                      \
+        type_name##_Heap *heap;                                                                            \
+                                                                                                           \
+        if (size > capacity)                                                                               \
+        {                                                                                                  \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        heap = (type_name##_Heap *)heap_alloc(NULL, sizeof(type_name##_Heap));                             \
+                                                                                                           \
+        if (heap == NULL)                                                                                  \
+        {                                                                                                  \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        heap->block = buffer;                                                                              \
+        heap->block_size = sizeof(type) * (capacity + (arity) - 1);                                        \
+        heap->context = NULL;                                                                              \
+        heap->elements = buffer;                                                                           \
+        heap->size = size;                                                                                 \
+        heap->capacity = capacity;                                                                         \
+        HEAP_STATS_RESET(heap);                                                                            \
+        type_name##_heap_heapify(heap);                                                                    \
+                                                                                                           \
+        return heap;                                                                                       \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Inserts a new element into the heap, the heap grows if it is full.                                  \
      *                                                                                                     \
      * @param Heap *heap                                                                                   \
      * @param type element                                                                                 \
      */                                                                                                    \
     void type_name##_heap_push(type_name##_Heap *heap, type element)                                       \
     {                                                                                                      \
-        /*increment heap size, insert element at the bottom of the heap and sort up */                     \
-        heap->elements[++heap->size] = element;                                                            \
+        /* grow if necessary, increment heap size, insert element at the bottom of the heap and sort up */ \
+        type_name##_heap_grow(heap, 1);                                                                    \
+        heap->size++;                                                                                      \
+        heap->elements[HEAP_LAST_INDEX(heap, arity)] = element;                                            \
+        HEAP_STATS_ADD(heap, moves, 1);                                                                    \
         type_name##_heap_sort_up(heap);                                                                    \
                                                                                                            \
         return;                                                                                            \
     }                                                                                                      \
                                                                                                            \
+    /*                                                                                                     \
+     * Inserts count elements into the heap.                                                               \
+     * Batches smaller than the heap are sorted up one by one, larger ones are appended                    \
+     * and the whole heap is rebuilt in O(n).                                                              \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @param const type *array                                                                            \
+     * @param size_t count number of elements in array                                                     \
+     */                                                                                                    \
+    void type_name##_heap_push_batch(type_name##_Heap *heap, const type *array, size_t count)              \
+    {                                                                                                      \
+        size_t size = heap->size + count;                                                                  \
+        size_t i;                                                                                          \
+                                                                                                           \
+        type_name##_heap_grow(heap, count);                                                                \
+                                                                                                           \
+        /* random elements are sorted up with about 2 comparisons each and a rebuild takes about 2 * size, \
+           so only batches at least as large as the heap are worth a rebuild */                            \
+        if (count >= heap->size)                                                                           \
+        {                                                                                                  \
+            memcpy(heap->elements + HEAP_LAST_INDEX(heap, arity) + 1, array, sizeof(type) * count);        \
+            HEAP_STATS_ADD(heap, moves, count);                                                            \
+            heap->size = size;                                                                             \
+            type_name##_heap_heapify(heap);                                                                \
+        }                                                                                                  \
+        else                                                                                               \
+        {                                                                                                  \
+            for (i = 0; i < count; i++)                                                                    \
+            {                                                                                              \
+                heap->size++;                                                                              \
+                heap->elements[HEAP_LAST_INDEX(heap, arity)] = array[i];                                   \
+                HEAP_STATS_ADD(heap, moves, 1);                                                            \
+                type_name##_heap_sort_up(heap);                                                            \
+            }                                                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
     /*                                                                                                     \
      * Removes and returns the top element from the heap.                                                  \
      *                                                                                                     \
@@ -203,10 +673,12 @@
                                                                                                            \
         if (heap->size > 0)                                                                                \
         {                                                                                                  \
-            element = heap->elements[1];                                                                   \
+            element = heap->elements[HEAP_TOP_INDEX(arity)];                                               \
                                                                                                            \
             /* move last element of the heap to the top, decrement heap size and sort down */              \
-            heap->elements[1] = heap->elements[heap->size--];                                              \
+            heap->elements[HEAP_TOP_INDEX(arity)] = heap->elements[HEAP_LAST_INDEX(heap, arity)];          \
+            heap->size--;                                                                                  \
+            HEAP_STATS_ADD(heap, moves, 1);                                                                \
             type_name##_heap_sort_down(heap);                                                              \
         }                                                                                                  \
         else                                                                                               \
@@ -216,4 +688,561 @@
         }                                                                                                  \
                                                                                                            \
         return element;                                                                                    \
-    }
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Returns the top element of the heap without removing it.                                            \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @return type element                                                                                \
+     */                                                                                                    \
+    type type_name##_heap_top(type_name##_Heap *heap)                                                      \
+    {                                                                                                      \
+        if (heap->size == 0)                                                                               \
+        {                                                                                                  \
+            printf("[Error]: attempting to get element from empty heap\nTerminating...\n");                \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        return heap->elements[HEAP_TOP_INDEX(arity)];                                                      \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Returns a pointer to the top element of the heap without copying it, NULL if the heap is empty.     \
+     * The pointer is valid until the heap is changed.                                                     \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @return const type *element                                                                         \
+     */                                                                                                    \
+    const type *type_name##_heap_peek(type_name##_Heap *heap)                                              \
+    {                                                                                                      \
+        return heap->size > 0 ? &heap->elements[HEAP_TOP_INDEX(arity)] : NULL;                             \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Removes and returns the top element and inserts a new element with a single sort down.              \
+     * Same as a pop followed by a push.                                                                   \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @param type element                                                                                 \
+     * @return type top element before the new element was inserted                                        \
+     */                                                                                                    \
+    type type_name##_heap_replace_top(type_name##_Heap *heap, type element)                                \
+    {                                                                                                      \
+        type top = type_name##_heap_top(heap);                                                             \
+                                                                                                           \
+        /* overwrite the top element and sort it down */                                                   \
+        heap->elements[HEAP_TOP_INDEX(arity)] = element;                                                   \
+        HEAP_STATS_ADD(heap, moves, 1);                                                                    \
+        type_name##_heap_sort_down(heap);                                                                  \
+                                                                                                           \
+        return top;                                                                                        \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Inserts a new element, then removes and returns the top element with at most a single sort down.    \
+     * Same as a push followed by a pop.                                                                   \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @param type element                                                                                 \
+     * @return type top element after the new element was inserted                                         \
+     */                                                                                                    \
+    type type_name##_heap_pushpop(type_name##_Heap *heap, type element)                                    \
+    {                                                                                                      \
+        type top;                                                                                          \
+                                                                                                           \
+        if (heap->size == 0 ||                                                                             \
+            HEAP_COMPARE(heap, compare_by, type_compare,                                                   \
+                         element, heap->elements[HEAP_TOP_INDEX(arity)]) >= 0)                             \
+        {                                                                                                  \
+            /* the new element would be the top element, so the heap stays unchanged */                    \
+            return element;                                                                                \
+        }                                                                                                  \
+                                                                                                           \
+        top = heap->elements[HEAP_TOP_INDEX(arity)];                                                       \
+        heap->elements[HEAP_TOP_INDEX(arity)] = element;                                                   \
+        HEAP_STATS_ADD(heap, moves, 1);                                                                    \
+        type_name##_heap_sort_down(heap);                                                                  \
+                                                                                                           \
+        return top;                                                                                        \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Inserts a new element into a heap bounded to limit elements, to keep the limit greatest             \
+     * elements of a stream (top-k). Once the heap is full, an element that is not greater than            \
+     * the top element, i.e. the smallest kept one, is rejected with a single comparison,                  \
+     * otherwise it replaces the top element.                                                              \
+     *                                                                                                     \
+     * @param Heap *heap                                                                                   \
+     * @param type element                                                                                 \
+     * @param size_t limit                                                                                 \
+     * @return int 1 if the element was inserted, 0 if it was rejected                                     \
+     */                                                                                                    \
+    int type_name##_heap_push_bounded(type_name##_Heap *heap, type element, size_t limit)                  \
+    {                                                                                                      \
+        if (heap->size < limit)                                                                            \
+        {                                                                                                  \
+            type_name##_heap_push(heap, element);                                                          \
+                                                                                                           \
+            return 1;                                                                                      \
+        }                                                                                                  \
+                                                                                                           \
+        if (heap->size == 0 ||                                                                             \
+            HEAP_COMPARE(heap, compare_by, type_compare,                                                   \
+                         element, heap->elements[HEAP_TOP_INDEX(arity)]) >= 0)                             \
+        {                                                                                                  \
+            return 0;                                                                                      \
+        }                                                                                                  \
+                                                                                                           \
+        heap->elements[HEAP_TOP_INDEX(arity)] = element;                                                   \
+        HEAP_STATS_ADD(heap, moves, 1);                                                                    \
+        type_name##_heap_sort_down(heap);                                                                  \
+                                                                                                           \
+        return 1;                                                                                          \
+    }
+
+/*
+ * Declare an indexed min heap with elements of type "type".
+ * Every pushed element gets a handle, which stays valid until the element is popped or removed,
+ * so elements can be changed or removed in O(log n) without searching them,
+ * e.g. to decrease the distance of a node in Dijkstra's algorithm instead of pushing it again.
+ * All declared functions will have the signature type_name_indexed_heap_FUNCTION.
+ * The heap struct will have the signature type_name_IndexedHeap.
+ * type_compare should return 0 if elements are equal, <0 if first element is bigger, >0 otherwise.
+ *
+ * WARNING: DECL_INDEXED_HEAP with a specific type_name may only be used once in a program.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ */
+#define DECL_INDEXED_HEAP(type, type_name, type_compare)                                                   \
+    DECL_INDEXED_HEAP_GENERIC(type, type_name, type_compare, HEAP_BY_VALUE)
+
+/*
+ * Declare an indexed min heap like DECL_INDEXED_HEAP, whose type_compare gets pointers to the elements:
+ * int type_compare(const type *a, const type *b), see DECL_HEAP_PTR.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ */
+#define DECL_INDEXED_HEAP_PTR(type, type_name, type_compare)                                               \
+    DECL_INDEXED_HEAP_GENERIC(type, type_name, type_compare, HEAP_BY_POINTER)
+
+/*
+ * Declare an indexed min heap like DECL_INDEXED_HEAP, whose type_compare gets pointers to elements:
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ * @param compare_by HEAP_BY_VALUE or HEAP_BY_POINTER, see DECL_HEAP_PTR
+ */
+#define DECL_INDEXED_HEAP_GENERIC(type, type_name, type_compare, compare_by)                               \
+    typedef struct type_name##_IndexedHeapNode                                                             \
+    {                                                                                                      \
+        type element;                                                                                      \
+        size_t handle;                                                                                     \
+    } type_name##_IndexedHeapNode;                                                                         \
+                                                                                                           \
+    typedef struct type_name##_IndexedHeap                                                                 \
+    {                                                                                                      \
+        size_t capacity;                                                                                   \
+        size_t size;                                                                                       \
+        type_name##_IndexedHeapNode *nodes;                                                                \
+        size_t *positions;                                                                                 \
+        HEAP_STATS_FIELD                                                                                   \
+    } type_name##_IndexedHeap;                                                                             \
+                                                                                                           \
+    /*                                                                                                     \
+     * Instanciates a dynamically allocated indexed heap struct and returns a pointer to it.               \
+     *                                                                                                     \
+     * @param size_t capacity                                                                              \
+     * @return IndexedHeap *heap                                                                           \
+     */                                                                                                    \
+    type_name##_IndexedHeap *type_name##_indexed_heap_create(size_t capacity)                              \
+    {                                                                                                      \
+        type_name##_IndexedHeap *heap;                                                                     \
+        size_t i;                                                                                          \
+                                                                                                           \
+        heap = (type_name##_IndexedHeap *)malloc(sizeof(type_name##_IndexedHeap));                         \
+                                                                                                           \
+        if (heap == NULL)                                                                                  \
+        {                                                                                                  \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        /* Note: like in the plain heap, heap->nodes[0] is not used, the top node is at index 1.           \
+           positions[handle] is the index of the node with that handle, 0 if the handle is unused. */      \
+        heap->nodes = (type_name##_IndexedHeapNode *)malloc(sizeof(*heap->nodes) * (capacity + 1));        \
+        heap->positions = (size_t *)malloc(sizeof(size_t) * (capacity + 1));                               \
+                                                                                                           \
+        if (heap->nodes == NULL || heap->positions == NULL)                                                \
+        {                                                                                                  \
+            free(heap->nodes);                                                                             \
+            free(heap->positions);                                                                         \
+            free(heap);                                                                                    \
+                                                                                                           \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        /* the unused nodes behind the last node hold the unused handles,                                  \
+           a push takes the handle of the node it is written to */                                         \
+        for (i = 1; i <= capacity; i++)                                                                    \
+        {                                                                                                  \
+            heap->nodes[i].handle = i - 1;                                                                 \
+            heap->positions[i - 1] = 0;                                                                    \
+        }                                                                                                  \
+                                                                                                           \
+        heap->size = 0;                                                                                    \
+        heap->capacity = capacity;                                                                         \
+        HEAP_STATS_RESET(heap);                                                                            \
+                                                                                                           \
+        return heap;                                                                                       \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Deallocates the indexed heap struct and its elements.                                               \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     */                                                                                                    \
+    void type_name##_indexed_heap_destroy(type_name##_IndexedHeap *heap)                                   \
+    {                                                                                                      \
+        free(heap->nodes);                                                                                 \
+        free(heap->positions);                                                                             \
+        free(heap);                                                                                        \
+                                                                                                           \
+        heap = NULL;                                                                                       \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Doubles the capacity of the indexed heap, the new nodes get the new handles.                        \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     */                                                                                                    \
+    void type_name##_indexed_heap_grow(type_name##_IndexedHeap *heap)                                      \
+    {                                                                                                      \
+        size_t capacity = heap->capacity < HEAP_MIN_CAPACITY ? HEAP_MIN_CAPACITY : heap->capacity * 2;     \
+        type_name##_IndexedHeapNode *nodes;                                                                \
+        size_t *positions;                                                                                 \
+        size_t i;                                                                                          \
+                                                                                                           \
+        nodes = (type_name##_IndexedHeapNode *)realloc(heap->nodes, sizeof(*nodes) * (capacity + 1));      \
+                                                                                                           \
+        if (nodes != NULL)                                                                                 \
+        {                                                                                                  \
+            heap->nodes = nodes;                                                                           \
+        }                                                                                                  \
+                                                                                                           \
+        positions = (size_t *)realloc(heap->positions, sizeof(size_t) * (capacity + 1));                   \
+                                                                                                           \
+        if (nodes == NULL || positions == NULL)                                                            \
+        {                                                                                                  \
+            printf("[Error]: could not allocate memory for heap elements\nTerminating...\n");              \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        heap->positions = positions;                                                                       \
+                                                                                                           \
+        for (i = heap->capacity + 1; i <= capacity; i++)                                                   \
+        {                                                                                                  \
+            heap->nodes[i].handle = i - 1;                                                                 \
+            heap->positions[i - 1] = 0;                                                                    \
+        }                                                                                                  \
+                                                                                                           \
+        heap->capacity = capacity;                                                                         \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Sorting from the node at index upwards, updating the positions of all moved nodes.                  \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @param size_t index                                                                                 \
+     * @return size_t final index of the sorted node                                                       \
+     */                                                                                                    \
+    size_t type_name##_indexed_heap_sort_up(type_name##_IndexedHeap *heap, size_t index)                   \
+    {                                                                                                      \
+        size_t currentIndex = index;                                                                       \
+        size_t parentIndex;                                                                                \
+        size_t depth = 0;                                                                                  \
+        /* temporarily save the node as the one to be sorted up */                                         \
+        type_name##_IndexedHeapNode sortNode = heap->nodes[currentIndex];                                  \
+                                                                                                           \
+        while (currentIndex > 1)                                                                           \
+        {                                                                                                  \
+            parentIndex = currentIndex / 2;                                                                \
+                                                                                                           \
+            if (HEAP_COMPARE(heap, compare_by, type_compare,                                               \
+                             heap->nodes[parentIndex].element, sortNode.element) < 0)                      \
+            {                                                                                              \
+                /* move parent node down if it's greater than the current one */                           \
+                heap->nodes[currentIndex] = heap->nodes[parentIndex];                                      \
+                heap->positions[heap->nodes[currentIndex].handle] = currentIndex;                          \
+                currentIndex = parentIndex;                                                                \
+                depth++;                                                                                   \
+            }                                                                                              \
+            else                                                                                           \
+            {                                                                                              \
+                /* currentIndex is correct position for sortNode */                                        \
+                break;                                                                                     \
+            }                                                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        /* insert sortNode at determined position */                                                       \
+        heap->nodes[currentIndex] = sortNode;                                                              \
+        heap->positions[sortNode.handle] = currentIndex;                                                   \
+        HEAP_STATS_ADD(heap, moves, depth + 1);                                                            \
+        HEAP_STATS_DEPTH(heap, depth);                                                                     \
+                                                                                                           \
+        return currentIndex;                                                                               \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Sorting from the node at index downwards bottom-up like type_name_heap_sort_down_from,              \
+     * updating the positions of all moved nodes.                                                          \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @param size_t index                                                                                 \
+     * @return size_t final index of the sorted node                                                       \
+     */                                                                                                    \
+    size_t type_name##_indexed_heap_sort_down(type_name##_IndexedHeap *heap, size_t index)                 \
+    {                                                                                                      \
+        size_t currentIndex = index;                                                                       \
+        size_t childIndex, parentIndex;                                                                    \
+        size_t depth = 0, height = 0;                                                                      \
+        /* temporarily save the node as the one to be sorted down */                                       \
+        type_name##_IndexedHeapNode sortNode = heap->nodes[currentIndex];                                  \
+                                                                                                           \
+        /* for node n: left child at 2n, right child at 2n+1 */                                            \
+        while ((childIndex = 2 * currentIndex) <= heap->size)                                              \
+        {                                                                                                  \
+            if (childIndex + 1 <= heap->size &&                                                            \
+                HEAP_COMPARE(heap, compare_by, type_compare, heap->nodes[childIndex].element,              \
+                             heap->nodes[childIndex + 1].element) < 0)                                     \
+            {                                                                                              \
+                /* right child exists and is smaller than the left child */                                \
+                childIndex++;                                                                              \
+            }                                                                                              \
+                                                                                                           \
+            /* move smaller child up without comparing it to sortNode, move on from its index */           \
+            heap->nodes[currentIndex] = heap->nodes[childIndex];                                           \
+            heap->positions[heap->nodes[currentIndex].handle] = currentIndex;                              \
+            currentIndex = childIndex;                                                                     \
+            depth++;                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        /* reached the bottom of the heap, sort sortNode up, but not above index */                        \
+        while (currentIndex > index)                                                                       \
+        {                                                                                                  \
+            parentIndex = currentIndex / 2;                                                                \
+                                                                                                           \
+            if (HEAP_COMPARE(heap, compare_by, type_compare,                                               \
+                             heap->nodes[parentIndex].element, sortNode.element) < 0)                      \
+            {                                                                                              \
+                /* move parent node down if it's greater than sortNode */                                  \
+                heap->nodes[currentIndex] = heap->nodes[parentIndex];                                      \
+                heap->positions[heap->nodes[currentIndex].handle] = currentIndex;                          \
+                currentIndex = parentIndex;                                                                \
+                height++;                                                                                  \
+            }                                                                                              \
+            else                                                                                           \
+            {                                                                                              \
+                /* currentIndex is correct position for sortNode */                                        \
+                break;                                                                                     \
+            }                                                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        /* insert sortNode at determined position */                                                       \
+        heap->nodes[currentIndex] = sortNode;                                                              \
+        heap->positions[sortNode.handle] = currentIndex;                                                   \
+        HEAP_STATS_ADD(heap, moves, depth + height + 1);                                                   \
+        HEAP_STATS_DEPTH(heap, depth - height);                                                            \
+                                                                                                           \
+        return currentIndex;                                                                               \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Inserts a new element into the indexed heap, the heap grows if it is full.                          \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @param type element                                                                                 \
+     * @return size_t handle of the element                                                                \
+     */                                                                                                    \
+    size_t type_name##_indexed_heap_push(type_name##_IndexedHeap *heap, type element)                      \
+    {                                                                                                      \
+        size_t handle;                                                                                     \
+                                                                                                           \
+        if (heap->size == heap->capacity)                                                                  \
+        {                                                                                                  \
+            type_name##_indexed_heap_grow(heap);                                                           \
+        }                                                                                                  \
+                                                                                                           \
+        /* increment heap size, insert element with the unused handle of the new last node and sort up */  \
+        heap->size++;                                                                                      \
+        handle = heap->nodes[heap->size].handle;                                                           \
+        heap->nodes[heap->size].element = element;                                                         \
+        type_name##_indexed_heap_sort_up(heap, heap->size);                                                \
+                                                                                                           \
+        return handle;                                                                                     \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Returns whether handle belongs to an element of the indexed heap.                                   \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @param size_t handle                                                                                \
+     * @return int 1 if the element is in the heap, 0 otherwise                                            \
+     */                                                                                                    \
+    int type_name##_indexed_heap_contains(type_name##_IndexedHeap *heap, size_t handle)                    \
+    {                                                                                                      \
+        return handle < heap->capacity && heap->positions[handle] != 0;                                    \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Returns the element with the given handle.                                                          \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @param size_t handle                                                                                \
+     * @return type element                                                                                \
+     */                                                                                                    \
+    type type_name##_indexed_heap_get(type_name##_IndexedHeap *heap, size_t handle)                        \
+    {                                                                                                      \
+        if (!type_name##_indexed_heap_contains(heap, handle))                                              \
+        {                                                                                                  \
+            printf("[Error]: attempting to get element with invalid handle\nTerminating...\n");            \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        return heap->nodes[heap->positions[handle]].element;                                               \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Replaces the element with the given handle by a smaller or equal element.                           \
+     * This is checked with assert, i.e. unless NDEBUG is defined; use update for any element.             \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @param size_t handle                                                                                \
+     * @param type element                                                                                 \
+     */                                                                                                    \
+    void type_name##_indexed_heap_decrease_key(type_name##_IndexedHeap *heap, size_t handle, type element) \
+    {                                                                                                      \
+        if (!type_name##_indexed_heap_contains(heap, handle))                                              \
+        {                                                                                                  \
+            printf("[Error]: attempting to change element with invalid handle\nTerminating...\n");         \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        assert(compare_by(type_compare, element, heap->nodes[heap->positions[handle]].element) >= 0 &&     \
+               "decrease_key may not make an element larger, use update instead");                         \
+                                                                                                           \
+        heap->nodes[heap->positions[handle]].element = element;                                            \
+        type_name##_indexed_heap_sort_up(heap, heap->positions[handle]);                                   \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Replaces the element with the given handle by any element.                                          \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @param size_t handle                                                                                \
+     * @param type element                                                                                 \
+     */                                                                                                    \
+    void type_name##_indexed_heap_update(type_name##_IndexedHeap *heap, size_t handle, type element)       \
+    {                                                                                                      \
+        size_t index;                                                                                      \
+                                                                                                           \
+        if (!type_name##_indexed_heap_contains(heap, handle))                                              \
+        {                                                                                                  \
+            printf("[Error]: attempting to change element with invalid handle\nTerminating...\n");         \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        index = heap->positions[handle];                                                                   \
+        heap->nodes[index].element = element;                                                              \
+                                                                                                           \
+        /* the node has to be sorted down if it could not be sorted up */                                  \
+        if (type_name##_indexed_heap_sort_up(heap, index) == index)                                        \
+        {                                                                                                  \
+            type_name##_indexed_heap_sort_down(heap, index);                                               \
+        }                                                                                                  \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Removes and returns the element with the given handle from the indexed heap.                        \
+     * The handle becomes invalid and may be returned by a later push.                                     \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @param size_t handle                                                                                \
+     * @return type element                                                                                \
+     */                                                                                                    \
+    type type_name##_indexed_heap_remove(type_name##_IndexedHeap *heap, size_t handle)                     \
+    {                                                                                                      \
+        type_name##_IndexedHeapNode lastNode;                                                              \
+        type element;                                                                                      \
+        size_t index;                                                                                      \
+                                                                                                           \
+        if (!type_name##_indexed_heap_contains(heap, handle))                                              \
+        {                                                                                                  \
+            printf("[Error]: attempting to remove element with invalid handle\nTerminating...\n");         \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        index = heap->positions[handle];                                                                   \
+        element = heap->nodes[index].element;                                                              \
+                                                                                                           \
+        /* take the last node out, its slot keeps the now unused handle */                                 \
+        lastNode = heap->nodes[heap->size];                                                                \
+        heap->nodes[heap->size].handle = handle;                                                           \
+        heap->positions[handle] = 0;                                                                       \
+        heap->size--;                                                                                      \
+                                                                                                           \
+        if (index <= heap->size)                                                                           \
+        {                                                                                                  \
+            /* move the last node to the free index and sort it up or down from there */                   \
+            heap->nodes[index] = lastNode;                                                                 \
+                                                                                                           \
+            if (type_name##_indexed_heap_sort_up(heap, index) == index)                                    \
+            {                                                                                              \
+                type_name##_indexed_heap_sort_down(heap, index);                                           \
+            }                                                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        return element;                                                                                    \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Returns the handle of the top element of the indexed heap.                                          \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @return size_t handle                                                                               \
+     */                                                                                                    \
+    size_t type_name##_indexed_heap_top_handle(type_name##_IndexedHeap *heap)                              \
+    {                                                                                                      \
+        if (heap->size == 0)                                                                               \
+        {                                                                                                  \
+            printf("[Error]: attempting to get element from empty heap\nTerminating...\n");                \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        return heap->nodes[1].handle;                                                                      \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Removes and returns the top element from the indexed heap.                                          \
+     *                                                                                                     \
+     * @param IndexedHeap *heap                                                                            \
+     * @return type element                                                                                \
+     */                                                                                                    \
+    type type_name##_indexed_heap_pop(type_name##_IndexedHeap *heap)                                       \
+    {                                                                                                      \
+        return type_name##_indexed_heap_remove(heap, type_name##_indexed_heap_top_handle(heap));           \
+    }
+
+#endif
@@ -0,0 +1,502 @@
+/*
+ * K-way merge of sorted runs with a loser (tournament) tree, e.g. for the merge phase of an external sort.
+ */
+
+#ifndef MERGE_H
+#define MERGE_H
+
+#include "heap.h"
+
+/*
+ * Declare a k-way merge of runs of elements of type "type", each sorted by type_compare
+ * (smallest first, with the same type_compare as for DECL_HEAP).
+ * Runs are read through cursors over arrays (type_name_merge_run_array) or over binary files
+ * of elements (type_name_merge_run_file, type_name_merge_run_map with DECL_MERGE_MAPPED_RUNS).
+ * The loser tree needs a single path of log2(k) comparisons per output element,
+ * instead of popping and pushing a heap, and equal elements are output in the order of their runs.
+ * All declared functions will have the signature type_name_merge_FUNCTION.
+ * The merge struct will have the signature type_name_Merge.
+ *
+ * WARNING: DECL_MERGE with a specific type_name may only be used once in a program.
+ * Recommended usage:
+ * #ifndef TYPE_NAME_MERGE
+ * #define TYPE_NAME_MERGE
+ * DECL_MERGE(type, type_name, type_compare)
+ * #endif
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ */
+#define DECL_MERGE(type, type_name, type_compare)                                                          \
+    DECL_MERGE_GENERIC(type, type_name, type_compare, HEAP_BY_VALUE)
+
+/*
+ * Declare a k-way merge like DECL_MERGE, whose type_compare gets pointers to the elements:
+ * int type_compare(const type *a, const type *b), see DECL_HEAP_PTR.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ */
+#define DECL_MERGE_PTR(type, type_name, type_compare)                                                      \
+    DECL_MERGE_GENERIC(type, type_name, type_compare, HEAP_BY_POINTER)
+
+/*
+ * Declare a k-way merge with all options, DECL_MERGE and DECL_MERGE_PTR are shortcuts for it.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ * @param compare_by HEAP_BY_VALUE or HEAP_BY_POINTER, see DECL_HEAP_PTR
+ */
+#define DECL_MERGE_GENERIC(type, type_name, type_compare, compare_by)                                      \
+    /*                                                                                                     \
+     * Cursor over a sorted run. current to end are the buffered elements of the run,                      \
+     * refill loads the next ones and returns 0 at the end of the run (NULL if there are no more).         \
+     */                                                                                                    \
+    typedef struct type_name##_MergeRun                                                                    \
+    {                                                                                                      \
+        const type *current;                                                                               \
+        const type *end;                                                                                   \
+        int (*refill)(struct type_name##_MergeRun *run);                                                   \
+        void (*close)(struct type_name##_MergeRun *run);                                                   \
+        FILE *file;                                                                                        \
+        void *block;                                                                                       \
+        size_t block_size;                                                                                 \
+    } type_name##_MergeRun;                                                                                \
+                                                                                                           \
+    typedef struct type_name##_Merge                                                                       \
+    {                                                                                                      \
+        size_t count;                                                                                      \
+        size_t live;                                                                                       \
+        type_name##_MergeRun *runs;                                                                        \
+        /* copies of the next element of every run, so that the comparisons along a path                   \
+           do not have to go through the run cursors */                                                    \
+        type *heads;                                                                                       \
+        /* tree[0] is the run with the smallest element, tree[1 ... count - 1] are the runs                \
+           that lost at the inner nodes, the run i is the leaf count + i.                                  \
+           Exhausted runs are stored as count + run */                                                     \
+        size_t *tree;                                                                                      \
+    } type_name##_Merge;                                                                                   \
+                                                                                                           \
+    /*                                                                                                     \
+     * Makes run a cursor over size sorted elements of array, which have to stay valid during the merge.   \
+     *                                                                                                     \
+     * @param MergeRun *run                                                                                \
+     * @param const type *array                                                                            \
+     * @param size_t size                                                                                  \
+     */                                                                                                    \
+    void type_name##_merge_run_array(type_name##_MergeRun *run, const type *array, size_t size)            \
+    {                                                                                                      \
+        run->current = array;                                                                              \
+        run->end = array + size;                                                                           \
+        run->refill = NULL;                                                                                \
+        run->close = NULL;                                                                                 \
+        run->file = NULL;                                                                                  \
+        run->block = NULL;                                                                                 \
+        run->block_size = 0;                                                                               \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Reads the next elements of a file run into its buffer.                                              \
+     * Terminates if the file cannot be read, so that a failing run is not merged as if it had ended.      \
+     *                                                                                                     \
+     * @param MergeRun *run                                                                                \
+     * @return int 0 at the end of the file                                                                \
+     */                                                                                                    \
+    int type_name##_merge_run_file_refill(type_name##_MergeRun *run)                                       \
+    {                                                                                                      \
+        size_t size = fread(run->block, sizeof(type), run->block_size / sizeof(type), run->file);          \
+                                                                                                           \
+        if (ferror(run->file))                                                                             \
+        {                                                                                                  \
+            printf("[Error]: could not read merge run from file\nTerminating...\n");                       \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        run->current = (const type *)run->block;                                                           \
+        run->end = run->current + size;                                                                    \
+                                                                                                           \
+        return size > 0;                                                                                   \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Frees the buffer of a file run.                                                                     \
+     *                                                                                                     \
+     * @param MergeRun *run                                                                                \
+     */                                                                                                    \
+    void type_name##_merge_run_file_close(type_name##_MergeRun *run)                                       \
+    {                                                                                                      \
+        free(run->block);                                                                                  \
+        run->block = NULL;                                                                                 \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Makes run a cursor over a binary file of sorted elements, read with a buffer of buffer_size         \
+     * elements from its current position. The file stays open and owned by the caller.                    \
+     *                                                                                                     \
+     * @param MergeRun *run                                                                                \
+     * @param FILE *file opened in binary mode                                                             \
+     * @param size_t buffer_size number of elements per read, e.g. 1 MB / sizeof(type)                     \
+     * @return int 0 on success, -1 if the buffer could not be allocated                                   \
+     */                                                                                                    \
+    int type_name##_merge_run_file(type_name##_MergeRun *run, FILE *file, size_t buffer_size)              \
+    {                                                                                                      \
+        run->file = file;                                                                                  \
+        run->block_size = sizeof(type) * (buffer_size > 0 ? buffer_size : 1);                              \
+        run->block = malloc(run->block_size);                                                              \
+                                                                                                           \
+        if (run->block == NULL)                                                                            \
+        {                                                                                                  \
+            /* leave an empty run behind, which is safe to merge and close */                              \
+            run->current = run->end = NULL;                                                                \
+            run->refill = NULL;                                                                            \
+            run->close = NULL;                                                                             \
+                                                                                                           \
+            return -1;                                                                                     \
+        }                                                                                                  \
+                                                                                                           \
+        run->refill = type_name##_merge_run_file_refill;                                                   \
+        run->close = type_name##_merge_run_file_close;                                                     \
+                                                                                                           \
+        type_name##_merge_run_file_refill(run);                                                            \
+                                                                                                           \
+        return 0;                                                                                          \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Releases the resources of a run cursor (buffers, mappings), not the file or array it reads.         \
+     *                                                                                                     \
+     * @param MergeRun *run                                                                                \
+     */                                                                                                    \
+    void type_name##_merge_run_close(type_name##_MergeRun *run)                                            \
+    {                                                                                                      \
+        if (run->close != NULL)                                                                            \
+        {                                                                                                  \
+            run->close(run);                                                                               \
+        }                                                                                                  \
+                                                                                                           \
+        run->current = run->end = NULL;                                                                    \
+        run->close = NULL;                                                                                 \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Returns whether run a has a smaller next element than run b. Exhausted runs lose against all        \
+     * others, equal elements are won by the run with the lower index.                                     \
+     *                                                                                                     \
+     * @param Merge *merge                                                                                 \
+     * @param size_t a                                                                                     \
+     * @param size_t b                                                                                     \
+     * @return int                                                                                         \
+     */                                                                                                    \
+    int type_name##_merge_beats(type_name##_Merge *merge, size_t a, size_t b)                              \
+    {                                                                                                      \
+        int comparison;                                                                                    \
+                                                                                                           \
+        if (a >= merge->count || b >= merge->count)                                                        \
+        {                                                                                                  \
+            /* exhausted runs have the indices count ... 2 * count - 1 */                                  \
+            return a < b;                                                                                  \
+        }                                                                                                  \
+                                                                                                           \
+        comparison = compare_by(type_compare, merge->heads[a], merge->heads[b]);                           \
+                                                                                                           \
+        /* bitwise instead of logical operators, to be evaluated without branches */                       \
+        return (comparison > 0) | ((comparison == 0) & (a < b));                                           \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Copies the next element of a run into its head and returns the run,                                 \
+     * or count + run if it is exhausted.                                                                  \
+     *                                                                                                     \
+     * @param Merge *merge                                                                                 \
+     * @param size_t index                                                                                 \
+     * @return size_t                                                                                      \
+     */                                                                                                    \
+    size_t type_name##_merge_load(type_name##_Merge *merge, size_t index)                                  \
+    {                                                                                                      \
+        type_name##_MergeRun *run = &merge->runs[index];                                                   \
+                                                                                                           \
+        if (run->current == run->end && (run->refill == NULL || !run->refill(run)))                        \
+        {                                                                                                  \
+            merge->live--;                                                                                 \
+                                                                                                           \
+            return merge->count + index;                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        merge->heads[index] = *run->current;                                                               \
+                                                                                                           \
+        return index;                                                                                      \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Plays the tournament of the subtree at node, storing the loser of every inner node.                 \
+     *                                                                                                     \
+     * @param Merge *merge                                                                                 \
+     * @param size_t node                                                                                  \
+     * @return size_t winning run of the subtree                                                           \
+     */                                                                                                    \
+    size_t type_name##_merge_play(type_name##_Merge *merge, size_t node)                                   \
+    {                                                                                                      \
+        size_t left, right;                                                                                \
+                                                                                                           \
+        if (node >= merge->count)                                                                          \
+        {                                                                                                  \
+            /* leaf of run node - count */                                                                 \
+            return type_name##_merge_load(merge, node - merge->count);                                     \
+        }                                                                                                  \
+                                                                                                           \
+        left = type_name##_merge_play(merge, 2 * node);                                                    \
+        right = type_name##_merge_play(merge, 2 * node + 1);                                               \
+                                                                                                           \
+        if (type_name##_merge_beats(merge, left, right))                                                   \
+        {                                                                                                  \
+            merge->tree[node] = right;                                                                     \
+                                                                                                           \
+            return left;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        merge->tree[node] = left;                                                                          \
+                                                                                                           \
+        return right;                                                                                      \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Instanciates a merge of count runs and returns a pointer to it.                                     \
+     * The runs stay owned by the caller and have to be valid until the merge is destroyed.                \
+     *                                                                                                     \
+     * @param MergeRun *runs                                                                               \
+     * @param size_t count                                                                                 \
+     * @return Merge *merge                                                                                \
+     */                                                                                                    \
+    type_name##_Merge *type_name##_merge_create(type_name##_MergeRun *runs, size_t count)                  \
+    {                                                                                                      \
+        type_name##_Merge *merge = (type_name##_Merge *)malloc(sizeof(type_name##_Merge));                 \
+                                                                                                           \
+        if (merge == NULL)                                                                                 \
+        {                                                                                                  \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        merge->tree = (size_t *)malloc(sizeof(size_t) * (count > 0 ? count : 1));                          \
+        merge->heads = (type *)malloc(sizeof(type) * (count > 0 ? count : 1));                             \
+                                                                                                           \
+        if (merge->tree == NULL || merge->heads == NULL)                                                   \
+        {                                                                                                  \
+            free(merge->tree);                                                                             \
+            free(merge->heads);                                                                            \
+            free(merge);                                                                                   \
+                                                                                                           \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        merge->count = count;                                                                              \
+        merge->runs = runs;                                                                                \
+        merge->live = count;                                                                               \
+                                                                                                           \
+        /* the runs are the leaves count ... 2 * count - 1 below the inner nodes 1 ... count - 1 */        \
+        merge->tree[0] = count > 0 ? type_name##_merge_play(merge, 1) : 0;                                 \
+                                                                                                           \
+        return merge;                                                                                      \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Deallocates the merge struct, the runs have to be closed by the caller.                             \
+     *                                                                                                     \
+     * @param Merge *merge                                                                                 \
+     */                                                                                                    \
+    void type_name##_merge_destroy(type_name##_Merge *merge)                                               \
+    {                                                                                                      \
+        free(merge->tree);                                                                                 \
+        free(merge->heads);                                                                                \
+        free(merge);                                                                                       \
+                                                                                                           \
+        merge = NULL;                                                                                      \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Moves the winning run to its next element and replays its path to the root,                         \
+     * with one comparison per level.                                                                      \
+     *                                                                                                     \
+     * @param Merge *merge                                                                                 \
+     */                                                                                                    \
+    void type_name##_merge_advance(type_name##_Merge *merge)                                               \
+    {                                                                                                      \
+        size_t *tree = merge->tree;                                                                        \
+        size_t count = merge->count;                                                                       \
+        size_t index = tree[0];                                                                            \
+        size_t winner, loser, swap, node;                                                                  \
+                                                                                                           \
+        merge->runs[index].current++;                                                                      \
+        winner = type_name##_merge_load(merge, index);                                                     \
+                                                                                                           \
+        for (node = (index + count) / 2; node > 0; node /= 2)                                              \
+        {                                                                                                  \
+            loser = tree[node];                                                                            \
+                                                                                                           \
+            /* the former loser wins this node and moves on, swapped with a mask instead of a branch */    \
+            swap = (winner ^ loser) & ((size_t)0 - (size_t)type_name##_merge_beats(merge, loser, winner)); \
+            tree[node] = loser ^ swap;                                                                     \
+            winner ^= swap;                                                                                \
+        }                                                                                                  \
+                                                                                                           \
+        tree[0] = winner;                                                                                  \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Removes the smallest element of all runs.                                                           \
+     *                                                                                                     \
+     * @param Merge *merge                                                                                 \
+     * @param type *element receives the removed element                                                   \
+     * @return int 1 if an element was removed, 0 if all runs are exhausted                                \
+     */                                                                                                    \
+    int type_name##_merge_next(type_name##_Merge *merge, type *element)                                    \
+    {                                                                                                      \
+        if (merge->live == 0)                                                                              \
+        {                                                                                                  \
+            return 0;                                                                                      \
+        }                                                                                                  \
+                                                                                                           \
+        *element = merge->heads[merge->tree[0]];                                                           \
+        type_name##_merge_advance(merge);                                                                  \
+                                                                                                           \
+        return 1;                                                                                          \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Removes up to capacity of the smallest elements of all runs and writes them to output in order.     \
+     * Once a single run is left, its buffered elements are copied without comparisons.                    \
+     *                                                                                                     \
+     * @param Merge *merge                                                                                 \
+     * @param type *output                                                                                 \
+     * @param size_t capacity                                                                              \
+     * @return size_t number of written elements, less than capacity only if all runs are exhausted        \
+     */                                                                                                    \
+    size_t type_name##_merge_read(type_name##_Merge *merge, type *output, size_t capacity)                 \
+    {                                                                                                      \
+        type_name##_MergeRun *run;                                                                         \
+        size_t size = 0;                                                                                   \
+        size_t count;                                                                                      \
+                                                                                                           \
+        while (size < capacity && merge->live > 1)                                                         \
+        {                                                                                                  \
+            output[size++] = merge->heads[merge->tree[0]];                                                 \
+            type_name##_merge_advance(merge);                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        while (size < capacity && merge->live == 1)                                                        \
+        {                                                                                                  \
+            /* the winner is the last run with elements, copy as many of them at once as possible */       \
+            run = &merge->runs[merge->tree[0]];                                                            \
+            count = (size_t)(run->end - run->current);                                                     \
+                                                                                                           \
+            if (count > capacity - size)                                                                   \
+            {                                                                                              \
+                count = capacity - size;                                                                   \
+            }                                                                                              \
+                                                                                                           \
+            memcpy(output + size, run->current, sizeof(type) * count);                                     \
+            size += count;                                                                                 \
+            run->current += count;                                                                         \
+            merge->tree[0] = type_name##_merge_load(merge, merge->tree[0]);                                \
+        }                                                                                                  \
+                                                                                                           \
+        return size;                                                                                       \
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Declare type_name_merge_run_map, a cursor over a memory-mapped binary file of sorted elements,
+ * for a merge declared with DECL_MERGE and the same type and type_name. Only available on POSIX systems,
+ * which may require defining _POSIX_C_SOURCE (or _DEFAULT_SOURCE) before including any header.
+ *
+ * @param type
+ * @param type_name
+ */
+#define DECL_MERGE_MAPPED_RUNS(type, type_name)                                                            \
+    /*                                                                                                     \
+     * Unmaps the file of a mapped run.                                                                    \
+     *                                                                                                     \
+     * @param MergeRun *run                                                                                \
+     */                                                                                                    \
+    void type_name##_merge_run_map_close(type_name##_MergeRun *run)                                        \
+    {                                                                                                      \
+        munmap(run->block, run->block_size);                                                               \
+        run->block = NULL;                                                                                 \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Makes run a cursor over the binary file of sorted elements at path, which is mapped into memory     \
+     * and read sequentially without copying.                                                              \
+     *                                                                                                     \
+     * @param MergeRun *run                                                                                \
+     * @param const char *path                                                                             \
+     * @return int 0 on success, -1 if the file could not be opened or mapped                              \
+     */                                                                                                    \
+    int type_name##_merge_run_map(type_name##_MergeRun *run, const char *path)                             \
+    {                                                                                                      \
+        struct stat status;                                                                                \
+        void *mapping = NULL;                                                                              \
+        int file = open(path, O_RDONLY);                                                                   \
+                                                                                                           \
+        if (file < 0)                                                                                      \
+        {                                                                                                  \
+            return -1;                                                                                     \
+        }                                                                                                  \
+                                                                                                           \
+        if (fstat(file, &status) != 0)                                                                     \
+        {                                                                                                  \
+            close(file);                                                                                   \
+                                                                                                           \
+            return -1;                                                                                     \
+        }                                                                                                  \
+                                                                                                           \
+        if (status.st_size > 0)                                                                            \
+        {                                                                                                  \
+            mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);                 \
+        }                                                                                                  \
+                                                                                                           \
+        /* the mapping stays valid after closing the file */                                               \
+        close(file);                                                                                       \
+                                                                                                           \
+        if (mapping == MAP_FAILED)                                                                         \
+        {                                                                                                  \
+            return -1;                                                                                     \
+        }                                                                                                  \
+                                                                                                           \
+        if (mapping != NULL)                                                                               \
+        {                                                                                                  \
+            posix_madvise(mapping, (size_t)status.st_size, POSIX_MADV_SEQUENTIAL);                         \
+        }                                                                                                  \
+                                                                                                           \
+        run->block = mapping;                                                                              \
+        run->block_size = (size_t)status.st_size;                                                          \
+        run->current = (const type *)mapping;                                                              \
+        run->end = run->current + run->block_size / sizeof(type);                                          \
+        run->refill = NULL;                                                                                \
+        run->close = mapping != NULL ? type_name##_merge_run_map_close : NULL;                             \
+        run->file = NULL;                                                                                  \
+                                                                                                           \
+        return 0;                                                                                          \
+    }
+#endif
+
+#endif
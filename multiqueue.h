@@ -0,0 +1,332 @@
+/*
+ * Concurrent relaxed priority queue (MultiQueue) built on heap.h.
+ * Based on "MultiQueues: Simple Relaxed Concurrent Priority Queues" by Rihani, Sanders and Dementiev (SPAA 2015).
+ */
+
+#ifndef MULTIQUEUE_H
+#define MULTIQUEUE_H
+
+#include <pthread.h>
+
+#include "heap.h"
+
+/*
+ * Declare a concurrent relaxed min queue with elements of type "type", consisting of
+ * factor * threads sub-heaps that are each protected by their own lock.
+ * A push inserts into a random sub-heap, a pop compares the top elements of two random sub-heaps
+ * and removes the smaller one. Locks are only tried, a thread that finds a sub-heap locked
+ * picks other random sub-heaps instead of waiting.
+ *
+ * Ordering guarantees: no element is lost or returned twice, but pops are relaxed.
+ * The rank of a popped element among all elements in the queue is expected to be O(factor * threads),
+ * with exponentially decreasing probability of larger ranks (see the paper above).
+ * type_name_multiqueue_pop_strict locks all sub-heaps and returns the exact smallest element,
+ * for consumers that need strict ordering at a higher cost.
+ *
+ * The sub-heaps have to be declared first, with DECL_HEAP or DECL_DHEAP and the same type and type_name
+ * (or DECL_HEAP_PTR or DECL_DHEAP_PTR for DECL_MULTIQUEUE_PTR).
+ * All declared functions will have the signature type_name_multiqueue_FUNCTION.
+ * The queue struct will have the signature type_name_MultiQueue.
+ * Every thread passes its own random seed to push and pop, e.g. initialized with its thread number.
+ *
+ * WARNING: DECL_MULTIQUEUE with a specific type_name may only be used once in a program.
+ * Recommended usage:
+ * #ifndef TYPE_NAME_MULTIQUEUE
+ * #define TYPE_NAME_MULTIQUEUE
+ * DECL_HEAP(type, type_name, type_compare)
+ * DECL_MULTIQUEUE(type, type_name, type_compare)
+ * #endif
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ */
+#define DECL_MULTIQUEUE(type, type_name, type_compare)                                                     \
+    DECL_MULTIQUEUE_GENERIC(type, type_name, type_compare, HEAP_BY_VALUE)
+
+/*
+ * Declare a multiqueue like DECL_MULTIQUEUE, whose type_compare gets pointers to the elements:
+ * int type_compare(const type *a, const type *b), see DECL_HEAP_PTR.
+ * The sub-heaps have to be declared with DECL_HEAP_PTR or DECL_DHEAP_PTR.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ */
+#define DECL_MULTIQUEUE_PTR(type, type_name, type_compare)                                                 \
+    DECL_MULTIQUEUE_GENERIC(type, type_name, type_compare, HEAP_BY_POINTER)
+
+/*
+ * Declare a multiqueue with all options, DECL_MULTIQUEUE and DECL_MULTIQUEUE_PTR are shortcuts for it.
+ *
+ * @param type
+ * @param type_name
+ * @param type_compare
+ * @param compare_by HEAP_BY_VALUE or HEAP_BY_POINTER, see DECL_HEAP_PTR
+ */
+#define DECL_MULTIQUEUE_GENERIC(type, type_name, type_compare, compare_by)                                 \
+    typedef struct type_name##_MultiQueueSlot                                                              \
+    {                                                                                                      \
+        pthread_mutex_t lock;                                                                              \
+        type_name##_Heap *heap;                                                                            \
+        /* keeps locks of neighbouring sub-heaps in different cache lines */                               \
+        char padding[HEAP_CACHE_LINE_SIZE];                                                                \
+    } type_name##_MultiQueueSlot;                                                                          \
+                                                                                                           \
+    typedef struct type_name##_MultiQueue                                                                  \
+    {                                                                                                      \
+        size_t count;                                                                                      \
+        type_name##_MultiQueueSlot *slots;                                                                 \
+    } type_name##_MultiQueue;                                                                              \
+                                                                                                           \
+    /*                                                                                                     \
+     * Instanciates a dynamically allocated multiqueue with factor * threads sub-heaps                     \
+     * and returns a pointer to it.                                                                        \
+     *                                                                                                     \
+     * @param size_t threads number of threads using the queue                                             \
+     * @param size_t factor number of sub-heaps per thread, 2 is a good default                            \
+     * @param size_t capacity initial capacity of all sub-heaps together                                   \
+     * @return MultiQueue *queue                                                                           \
+     */                                                                                                    \
+    type_name##_MultiQueue *type_name##_multiqueue_create(size_t threads, size_t factor, size_t capacity)  \
+    {                                                                                                      \
+        type_name##_MultiQueue *queue = (type_name##_MultiQueue *)malloc(sizeof(type_name##_MultiQueue));  \
+        size_t i;                                                                                          \
+                                                                                                           \
+        if (queue == NULL)                                                                                 \
+        {                                                                                                  \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        queue->count = threads * factor > 0 ? threads * factor : 1;                                        \
+        queue->slots = (type_name##_MultiQueueSlot *)malloc(sizeof(*queue->slots) * queue->count);         \
+                                                                                                           \
+        if (queue->slots == NULL)                                                                          \
+        {                                                                                                  \
+            free(queue);                                                                                   \
+                                                                                                           \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        for (i = 0; i < queue->count; i++)                                                                 \
+        {                                                                                                  \
+            queue->slots[i].heap = type_name##_heap_create(capacity / queue->count);                       \
+                                                                                                           \
+            if (queue->slots[i].heap == NULL)                                                              \
+            {                                                                                              \
+                while (i-- > 0)                                                                            \
+                {                                                                                          \
+                    pthread_mutex_destroy(&queue->slots[i].lock);                                          \
+                    type_name##_heap_destroy(queue->slots[i].heap);                                        \
+                }                                                                                          \
+                                                                                                           \
+                free(queue->slots);                                                                        \
+                free(queue);                                                                               \
+                                                                                                           \
+                return NULL;                                                                               \
+            }                                                                                              \
+                                                                                                           \
+            pthread_mutex_init(&queue->slots[i].lock, NULL);                                               \
+        }                                                                                                  \
+                                                                                                           \
+        return queue;                                                                                      \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Deallocates the multiqueue and all sub-heaps. No thread may use the queue anymore.                  \
+     *                                                                                                     \
+     * @param MultiQueue *queue                                                                            \
+     */                                                                                                    \
+    void type_name##_multiqueue_destroy(type_name##_MultiQueue *queue)                                     \
+    {                                                                                                      \
+        size_t i;                                                                                          \
+                                                                                                           \
+        for (i = 0; i < queue->count; i++)                                                                 \
+        {                                                                                                  \
+            pthread_mutex_destroy(&queue->slots[i].lock);                                                  \
+            type_name##_heap_destroy(queue->slots[i].heap);                                                \
+        }                                                                                                  \
+                                                                                                           \
+        free(queue->slots);                                                                                \
+        free(queue);                                                                                       \
+                                                                                                           \
+        queue = NULL;                                                                                      \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Returns a random sub-heap index and advances the seed of the calling thread.                        \
+     *                                                                                                     \
+     * @param MultiQueue *queue                                                                            \
+     * @param unsigned long *seed                                                                          \
+     * @return size_t index                                                                                \
+     */                                                                                                    \
+    size_t type_name##_multiqueue_random(type_name##_MultiQueue *queue, unsigned long *seed)               \
+    {                                                                                                      \
+        /* 32 bit linear congruential generator, the high bits are the most random ones */                 \
+        *seed = (*seed * 1103515245UL + 12345UL) & 0xffffffffUL;                                           \
+                                                                                                           \
+        return (size_t)(*seed >> 8) % queue->count;                                                        \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Inserts a new element into a random sub-heap. Thread-safe.                                          \
+     *                                                                                                     \
+     * @param MultiQueue *queue                                                                            \
+     * @param type element                                                                                 \
+     * @param unsigned long *seed random seed of the calling thread                                        \
+     */                                                                                                    \
+    void type_name##_multiqueue_push(type_name##_MultiQueue *queue, type element, unsigned long *seed)     \
+    {                                                                                                      \
+        type_name##_MultiQueueSlot *slot;                                                                  \
+                                                                                                           \
+        /* try random sub-heaps until one is not locked by another thread */                               \
+        do                                                                                                 \
+        {                                                                                                  \
+            slot = &queue->slots[type_name##_multiqueue_random(queue, seed)];                              \
+        } while (pthread_mutex_trylock(&slot->lock) != 0);                                                 \
+                                                                                                           \
+        type_name##_heap_push(slot->heap, element);                                                        \
+        pthread_mutex_unlock(&slot->lock);                                                                 \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Removes the smallest element of all sub-heaps while holding all locks. Thread-safe.                 \
+     *                                                                                                     \
+     * @param MultiQueue *queue                                                                            \
+     * @param type *element receives the removed element                                                   \
+     * @return int 1 if an element was removed, 0 if the queue was empty                                   \
+     */                                                                                                    \
+    int type_name##_multiqueue_pop_strict(type_name##_MultiQueue *queue, type *element)                    \
+    {                                                                                                      \
+        type_name##_Heap *smallest = NULL;                                                                 \
+        type_name##_Heap *heap;                                                                            \
+        const type *top = NULL;                                                                            \
+        const type *heapTop;                                                                               \
+        size_t i;                                                                                          \
+                                                                                                           \
+        /* always lock in index order, so concurrent strict pops cannot deadlock */                        \
+        for (i = 0; i < queue->count; i++)                                                                 \
+        {                                                                                                  \
+            pthread_mutex_lock(&queue->slots[i].lock);                                                     \
+            heap = queue->slots[i].heap;                                                                   \
+            heapTop = type_name##_heap_peek(heap);                                                         \
+                                                                                                           \
+            /* keep the heap with the smallest top element, compared in place */                           \
+            if (heapTop != NULL && (top == NULL || compare_by(type_compare, *top, *heapTop) < 0))          \
+            {                                                                                              \
+                smallest = heap;                                                                           \
+                top = heapTop;                                                                             \
+            }                                                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        if (smallest != NULL)                                                                              \
+        {                                                                                                  \
+            *element = type_name##_heap_pop(smallest);                                                     \
+        }                                                                                                  \
+                                                                                                           \
+        for (i = 0; i < queue->count; i++)                                                                 \
+        {                                                                                                  \
+            pthread_mutex_unlock(&queue->slots[i].lock);                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        return smallest != NULL;                                                                           \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Removes the smaller top element of two random sub-heaps. Thread-safe.                               \
+     * If the sampled sub-heaps are empty repeatedly, falls back to type_name_multiqueue_pop_strict,       \
+     * so 0 is only returned if all sub-heaps were empty.                                                  \
+     *                                                                                                     \
+     * @param MultiQueue *queue                                                                            \
+     * @param type *element receives the removed element                                                   \
+     * @param unsigned long *seed random seed of the calling thread                                        \
+     * @return int 1 if an element was removed, 0 if the queue was empty                                   \
+     */                                                                                                    \
+    int type_name##_multiqueue_pop(type_name##_MultiQueue *queue, type *element, unsigned long *seed)      \
+    {                                                                                                      \
+        type_name##_MultiQueueSlot *first, *second;                                                        \
+        type_name##_Heap *smallest;                                                                        \
+        const type *firstTop, *secondTop;                                                                  \
+        size_t emptyTries = 0;                                                                             \
+        int popped;                                                                                        \
+                                                                                                           \
+        if (queue->count < 2)                                                                              \
+        {                                                                                                  \
+            return type_name##_multiqueue_pop_strict(queue, element);                                      \
+        }                                                                                                  \
+                                                                                                           \
+        while (emptyTries < queue->count)                                                                  \
+        {                                                                                                  \
+            first = &queue->slots[type_name##_multiqueue_random(queue, seed)];                             \
+            second = &queue->slots[type_name##_multiqueue_random(queue, seed)];                            \
+                                                                                                           \
+            /* only try the locks, on contention sample two other sub-heaps */                             \
+            if (first == second || pthread_mutex_trylock(&first->lock) != 0)                               \
+            {                                                                                              \
+                continue;                                                                                  \
+            }                                                                                              \
+                                                                                                           \
+            if (pthread_mutex_trylock(&second->lock) != 0)                                                 \
+            {                                                                                              \
+                pthread_mutex_unlock(&first->lock);                                                        \
+                continue;                                                                                  \
+            }                                                                                              \
+                                                                                                           \
+            smallest = first->heap;                                                                        \
+            firstTop = type_name##_heap_peek(first->heap);                                                 \
+            secondTop = type_name##_heap_peek(second->heap);                                               \
+                                                                                                           \
+            if (secondTop != NULL &&                                                                       \
+                (firstTop == NULL || compare_by(type_compare, *firstTop, *secondTop) < 0))                 \
+            {                                                                                              \
+                smallest = second->heap;                                                                   \
+            }                                                                                              \
+                                                                                                           \
+            popped = smallest->size > 0;                                                                   \
+                                                                                                           \
+            if (popped)                                                                                    \
+            {                                                                                              \
+                *element = type_name##_heap_pop(smallest);                                                 \
+            }                                                                                              \
+                                                                                                           \
+            pthread_mutex_unlock(&second->lock);                                                           \
+            pthread_mutex_unlock(&first->lock);                                                            \
+                                                                                                           \
+            if (popped)                                                                                    \
+            {                                                                                              \
+                return 1;                                                                                  \
+            }                                                                                              \
+                                                                                                           \
+            emptyTries++;                                                                                  \
+        }                                                                                                  \
+                                                                                                           \
+        /* the sampled sub-heaps were empty, check all of them before reporting an empty queue */          \
+        return type_name##_multiqueue_pop_strict(queue, element);                                          \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Returns the number of elements in all sub-heaps. Only exact if no other thread uses the queue.      \
+     *                                                                                                     \
+     * @param MultiQueue *queue                                                                            \
+     * @return size_t size                                                                                 \
+     */                                                                                                    \
+    size_t type_name##_multiqueue_size(type_name##_MultiQueue *queue)                                      \
+    {                                                                                                      \
+        size_t size = 0;                                                                                   \
+        size_t i;                                                                                          \
+                                                                                                           \
+        for (i = 0; i < queue->count; i++)                                                                 \
+        {                                                                                                  \
+            pthread_mutex_lock(&queue->slots[i].lock);                                                     \
+            size += queue->slots[i].heap->size;                                                            \
+            pthread_mutex_unlock(&queue->slots[i].lock);                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        return size;                                                                                       \
+    }
+
+#endif
@@ -0,0 +1,270 @@
+/*
+ * Radix heap: a monotone min priority queue for unsigned integer keys.
+ * Based on "Faster Algorithms for the Shortest Path Problem" by Ahuja, Mehlhorn, Orlin and Tarjan (1990).
+ */
+
+#ifndef RADIX_HEAP_H
+#define RADIX_HEAP_H
+
+#include <assert.h>
+#include <limits.h>
+
+#include "heap.h"
+
+/*
+ * Number of significant bits of the unsigned integer x, 0 for x == 0.
+ * fallback is a function computing the same, used if no compiler builtin is available.
+ */
+#if defined(__GNUC__)
+#define RADIX_HEAP_BIT_LENGTH(x, fallback)                                                                 \
+    ((x) == 0 ? (size_t)0 : __extension__(size_t)(sizeof(unsigned long long) * CHAR_BIT -                  \
+                                                  __builtin_clzll((unsigned long long)(x))))
+#else
+#define RADIX_HEAP_BIT_LENGTH(x, fallback) fallback(x)
+#endif
+
+/*
+ * Declare a radix heap with unsigned integer keys of type "key_type" and values of type "value_type".
+ * Radix heaps are monotone: a pushed key may not be smaller than the key of the last popped element,
+ * as it is the case for event simulations and shortest path searches. This is checked with assert,
+ * i.e. unless NDEBUG is defined.
+ * Elements are kept in buckets by the highest bit in which their key differs from the last popped key,
+ * so push and pop take amortized O(log C) time for keys from a range of size C, without comparing elements.
+ * All declared functions will have the signature name_radix_heap_FUNCTION.
+ * The heap struct will have the signature name_RadixHeap.
+ *
+ * WARNING: DECL_RADIX_HEAP with a specific name may only be used once in a program.
+ * Recommended usage:
+ * #ifndef NAME_RADIX_HEAP
+ * #define NAME_RADIX_HEAP
+ * DECL_RADIX_HEAP(key_type, value_type, name)
+ * #endif
+ *
+ * @param key_type unsigned integer type
+ * @param value_type
+ * @param name
+ */
+#define DECL_RADIX_HEAP(key_type, value_type, name)                                                        \
+    typedef struct name##_RadixHeapEntry                                                                   \
+    {                                                                                                      \
+        key_type key;                                                                                      \
+        value_type value;                                                                                  \
+    } name##_RadixHeapEntry;                                                                               \
+                                                                                                           \
+    typedef struct name##_RadixHeapBucket                                                                  \
+    {                                                                                                      \
+        size_t capacity;                                                                                   \
+        size_t size;                                                                                       \
+        name##_RadixHeapEntry *entries;                                                                    \
+    } name##_RadixHeapBucket;                                                                              \
+                                                                                                           \
+    typedef struct name##_RadixHeap                                                                        \
+    {                                                                                                      \
+        size_t size;                                                                                       \
+        /* key of the last popped element, no key in the heap is smaller */                                \
+        key_type last;                                                                                     \
+        /* bucket 0 holds keys equal to last,                                                              \
+           bucket i keys whose highest bit that differs from last is bit i - 1 */                          \
+        name##_RadixHeapBucket buckets[sizeof(key_type) * CHAR_BIT + 1];                                   \
+    } name##_RadixHeap;                                                                                    \
+                                                                                                           \
+    /*                                                                                                     \
+     * Instanciates a dynamically allocated radix heap struct and returns a pointer to it.                 \
+     * The buckets are allocated on demand, capacity is the initial capacity of bucket 0.                  \
+     *                                                                                                     \
+     * @param size_t capacity                                                                              \
+     * @return RadixHeap *heap                                                                             \
+     */                                                                                                    \
+    name##_RadixHeap *name##_radix_heap_create(size_t capacity)                                            \
+    {                                                                                                      \
+        name##_RadixHeap *heap = (name##_RadixHeap *)malloc(sizeof(name##_RadixHeap));                     \
+        size_t i;                                                                                          \
+                                                                                                           \
+        if (heap == NULL)                                                                                  \
+        {                                                                                                  \
+            return NULL;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        for (i = 0; i < sizeof(heap->buckets) / sizeof(heap->buckets[0]); i++)                             \
+        {                                                                                                  \
+            heap->buckets[i].capacity = 0;                                                                 \
+            heap->buckets[i].size = 0;                                                                     \
+            heap->buckets[i].entries = NULL;                                                               \
+        }                                                                                                  \
+                                                                                                           \
+        if (capacity > 0)                                                                                  \
+        {                                                                                                  \
+            heap->buckets[0].entries = (name##_RadixHeapEntry *)malloc(sizeof(name##_RadixHeapEntry) *     \
+                                                                       capacity);                          \
+                                                                                                           \
+            if (heap->buckets[0].entries == NULL)                                                          \
+            {                                                                                              \
+                free(heap);                                                                                \
+                                                                                                           \
+                return NULL;                                                                               \
+            }                                                                                              \
+                                                                                                           \
+            heap->buckets[0].capacity = capacity;                                                          \
+        }                                                                                                  \
+                                                                                                           \
+        heap->size = 0;                                                                                    \
+        heap->last = 0;                                                                                    \
+                                                                                                           \
+        return heap;                                                                                       \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Deallocates the radix heap struct and its elements.                                                 \
+     *                                                                                                     \
+     * @param RadixHeap *heap                                                                              \
+     */                                                                                                    \
+    void name##_radix_heap_destroy(name##_RadixHeap *heap)                                                 \
+    {                                                                                                      \
+        size_t i;                                                                                          \
+                                                                                                           \
+        for (i = 0; i < sizeof(heap->buckets) / sizeof(heap->buckets[0]); i++)                             \
+        {                                                                                                  \
+            free(heap->buckets[i].entries);                                                                \
+        }                                                                                                  \
+                                                                                                           \
+        free(heap);                                                                                        \
+                                                                                                           \
+        heap = NULL;                                                                                       \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Number of significant bits of key, for compilers without a builtin for it.                          \
+     *                                                                                                     \
+     * @param key_type key                                                                                 \
+     * @return size_t length                                                                               \
+     */                                                                                                    \
+    size_t name##_radix_heap_bit_length(key_type key)                                                      \
+    {                                                                                                      \
+        size_t length = 0;                                                                                 \
+                                                                                                           \
+        /* shifting instead of comparing with 256, which is out of range for 8 bit keys */                 \
+        while ((key >> 8) != 0)                                                                            \
+        {                                                                                                  \
+            key >>= 8;                                                                                     \
+            length += 8;                                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        while (key > 0)                                                                                    \
+        {                                                                                                  \
+            key >>= 1;                                                                                     \
+            length++;                                                                                      \
+        }                                                                                                  \
+                                                                                                           \
+        return length;                                                                                     \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Appends an entry to the bucket its key belongs to relative to the last popped key.                  \
+     *                                                                                                     \
+     * @param RadixHeap *heap                                                                              \
+     * @param RadixHeapEntry entry                                                                         \
+     */                                                                                                    \
+    void name##_radix_heap_insert(name##_RadixHeap *heap, name##_RadixHeapEntry entry)                     \
+    {                                                                                                      \
+        key_type difference = entry.key ^ heap->last;                                                      \
+        name##_RadixHeapBucket *bucket;                                                                    \
+        name##_RadixHeapEntry *entries;                                                                    \
+        size_t capacity;                                                                                   \
+                                                                                                           \
+        bucket = &heap->buckets[RADIX_HEAP_BIT_LENGTH(difference, name##_radix_heap_bit_length)];          \
+                                                                                                           \
+        if (bucket->size == bucket->capacity)                                                              \
+        {                                                                                                  \
+            /* double the capacity of the bucket */                                                        \
+            capacity = bucket->capacity < HEAP_MIN_CAPACITY ? HEAP_MIN_CAPACITY : bucket->capacity * 2;    \
+            entries = (name##_RadixHeapEntry *)realloc(bucket->entries, sizeof(*entries) * capacity);      \
+                                                                                                           \
+            if (entries == NULL)                                                                           \
+            {                                                                                              \
+                printf("[Error]: could not allocate memory for heap elements\nTerminating...\n");          \
+                exit(1);                                                                                   \
+            }                                                                                              \
+                                                                                                           \
+            bucket->entries = entries;                                                                     \
+            bucket->capacity = capacity;                                                                   \
+        }                                                                                                  \
+                                                                                                           \
+        bucket->entries[bucket->size++] = entry;                                                           \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Inserts a new element into the radix heap.                                                          \
+     * key may not be smaller than the key of the last popped element.                                     \
+     *                                                                                                     \
+     * @param RadixHeap *heap                                                                              \
+     * @param key_type key                                                                                 \
+     * @param value_type value                                                                             \
+     */                                                                                                    \
+    void name##_radix_heap_push(name##_RadixHeap *heap, key_type key, value_type value)                    \
+    {                                                                                                      \
+        name##_RadixHeapEntry entry;                                                                       \
+                                                                                                           \
+        assert(key >= heap->last && "radix heap keys may not be smaller than the last popped key");        \
+                                                                                                           \
+        entry.key = key;                                                                                   \
+        entry.value = value;                                                                               \
+        name##_radix_heap_insert(heap, entry);                                                             \
+        heap->size++;                                                                                      \
+                                                                                                           \
+        return;                                                                                            \
+    }                                                                                                      \
+                                                                                                           \
+    /*                                                                                                     \
+     * Removes and returns the value of the element with the smallest key from the radix heap.             \
+     * Afterwards heap->last is the key of the removed element.                                            \
+     *                                                                                                     \
+     * @param RadixHeap *heap                                                                              \
+     * @return value_type value                                                                            \
+     */                                                                                                    \
+    value_type name##_radix_heap_pop(name##_RadixHeap *heap)                                               \
+    {                                                                                                      \
+        name##_RadixHeapBucket *bucket;                                                                    \
+        size_t i;                                                                                          \
+                                                                                                           \
+        if (heap->size == 0)                                                                               \
+        {                                                                                                  \
+            printf("[Error]: attempting to get element from empty heap\nTerminating...\n");                \
+            exit(1);                                                                                       \
+        }                                                                                                  \
+                                                                                                           \
+        if (heap->buckets[0].size == 0)                                                                    \
+        {                                                                                                  \
+            /* find the first non-empty bucket, its smallest key becomes the new last key */               \
+            for (bucket = &heap->buckets[1]; bucket->size == 0; bucket++)                                  \
+            {                                                                                              \
+            }                                                                                              \
+                                                                                                           \
+            heap->last = bucket->entries[0].key;                                                           \
+                                                                                                           \
+            for (i = 1; i < bucket->size; i++)                                                             \
+            {                                                                                              \
+                if (bucket->entries[i].key < heap->last)                                                   \
+                {                                                                                          \
+                    heap->last = bucket->entries[i].key;                                                   \
+                }                                                                                          \
+            }                                                                                              \
+                                                                                                           \
+            /* relative to the new last key all entries of the bucket belong to lower buckets */           \
+            for (i = 0; i < bucket->size; i++)                                                             \
+            {                                                                                              \
+                name##_radix_heap_insert(heap, bucket->entries[i]);                                        \
+            }                                                                                              \
+                                                                                                           \
+            bucket->size = 0;                                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        heap->size--;                                                                                      \
+                                                                                                           \
+        return heap->buckets[0].entries[--heap->buckets[0].size].value;                                    \
+    }
+
+#endif